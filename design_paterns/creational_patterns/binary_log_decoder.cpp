@@ -0,0 +1,183 @@
+// Offline decoder for the binary log files written by BinaryLogger (see singleton.cpp).
+//
+// BinaryLogger keeps the logging hot path cheap by deferring all text formatting: each record only holds a
+// call-site format id, a raw steady_clock timestamp and the packed arguments. This tool reads the format
+// definitions embedded in the file, converts the steady clock timestamps back to wall clock time and prints
+// every record in the same "timestamp : message" text layout that Logger writes.
+//
+// Usage: ./binary_log_decoder log_1678863670.bin > log_1678863670.txt
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+struct FormatDefinition {
+	std::string signature; // one code per argument: 'i', 'u', 'c', 'd' or 's'
+	std::string format;
+};
+
+class BinaryLogReader {
+public:
+	explicit BinaryLogReader(const std::string& filename) : in(filename, std::ios::binary) {}
+
+	bool readHeader() {
+		char magic[4];
+		std::uint32_t version = 0;
+		if (!in.read(magic, 4) || std::memcmp(magic, "BLOG", 4) != 0) return false;
+		return read(version) && version == 1 && read(wallAnchor) && read(steadyAnchor);
+	}
+
+	// Decodes the next log entry into `text`, consuming format definitions on the way.
+	bool next(std::string& text) {
+		std::uint8_t kind;
+		while (read(kind)) {
+			if (kind == 1) {
+				if (!readDefinition()) return false;
+			} else if (kind == 2) {
+				return readEntry(text);
+			} else {
+				std::cerr << "Corrupted record kind " << int(kind) << std::endl;
+				return false;
+			}
+		}
+		return false;
+	}
+
+private:
+	template <typename T>
+	bool read(T& value) {
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+	}
+
+	bool readString(std::string& value, std::size_t length) {
+		value.resize(length);
+		return length == 0 || static_cast<bool>(in.read(&value[0], length));
+	}
+
+	bool readDefinition() {
+		std::uint32_t id, formatLength;
+		std::uint16_t signatureLength;
+		FormatDefinition definition;
+		if (!read(id) || !read(signatureLength) || !readString(definition.signature, signatureLength)) return false;
+		if (!read(formatLength) || !readString(definition.format, formatLength)) return false;
+		formats[id] = definition;
+		return true;
+	}
+
+	bool readEntry(std::string& text) {
+		std::uint32_t id;
+		std::int64_t steady;
+		if (!read(id) || !read(steady)) return false;
+		auto it = formats.find(id);
+		if (it == formats.end()) {
+			std::cerr << "Unknown format id " << id << std::endl;
+			return false;
+		}
+		std::time_t seconds = static_cast<std::time_t>((wallAnchor + (steady - steadyAnchor)) / 1000000000);
+		text = std::ctime(&seconds);
+		text += " : ";
+		return render(it->second, text);
+	}
+
+	// Re-plays the printf conversions one at a time with the argument type recorded at the call site.
+	bool render(const FormatDefinition& definition, std::string& text) {
+		const std::string& format = definition.format;
+		std::size_t argument = 0;
+		char buffer[512];
+		for (std::size_t i = 0; i < format.size(); ++i) {
+			if (format[i] != '%') {
+				text += format[i];
+				continue;
+			}
+			if (i + 1 < format.size() && format[i + 1] == '%') {
+				text += '%';
+				++i;
+				continue;
+			}
+			std::size_t end = format.find_first_of("diouxXeEfFgGaAcsp", i + 1);
+			if (end == std::string::npos || argument >= definition.signature.size()) {
+				text += format.substr(i);
+				break;
+			}
+			std::string spec;
+			for (std::size_t k = i; k < end; ++k) { // keep flags / width / precision, drop length modifiers
+				if (std::strchr("hljztL", format[k]) == nullptr) spec += format[k];
+			}
+			char conversion = format[end];
+			char code = definition.signature[argument++];
+			// BINLOG rejects mismatched formats at compile time, but a damaged or foreign file could still pair a
+			// double with %d: print the value with a conversion of its own type rather than hand it to snprintf.
+			bool floating = std::strchr("eEfFgGaA", conversion) != nullptr;
+			if (code == 'd' && !floating) {
+				conversion = 'g';
+			} else if (code != 'd' && code != 's' && (floating || conversion == 's' || conversion == 'p')) {
+				conversion = code == 'c' ? 'c' : 'd';
+			}
+			if (code == 's') {
+				std::uint32_t length;
+				std::string value;
+				if (!read(length) || !readString(value, length)) return false;
+				std::string conversionSpec = spec + 's';
+				int size = std::snprintf(nullptr, 0, conversionSpec.c_str(), value.c_str()); // strings may exceed `buffer`
+				std::string formatted(size > 0 ? static_cast<std::size_t>(size) : 0, '\0');
+				std::snprintf(&formatted[0], formatted.size() + 1, conversionSpec.c_str(), value.c_str());
+				text += formatted;
+				i = end;
+				continue;
+			} else if (code == 'd') {
+				double value;
+				if (!read(value)) return false;
+				std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+			} else if (code == 'u' && conversion != 'c') {
+				std::uint64_t value;
+				if (!read(value)) return false;
+				std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), static_cast<unsigned long long>(value));
+			} else { // 'i', 'c', or an unsigned value printed with %c (same 8 bytes either way)
+				std::int64_t value;
+				if (!read(value)) return false;
+				if (conversion == 'c') {
+					std::snprintf(buffer, sizeof(buffer), (spec + 'c').c_str(), static_cast<int>(value));
+				} else {
+					std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), static_cast<long long>(value));
+				}
+			}
+			text += buffer;
+			i = end;
+		}
+		while (argument < definition.signature.size()) { // skip arguments the format never consumed
+			char code = definition.signature[argument++];
+			std::uint32_t length = 8;
+			if (code == 's' && !read(length)) return false;
+			in.ignore(length);
+		}
+		return true;
+	}
+
+	std::ifstream in;
+	std::int64_t wallAnchor = 0;   // system_clock ns when the logger started
+	std::int64_t steadyAnchor = 0; // steady_clock ns at the same instant
+	std::unordered_map<std::uint32_t, FormatDefinition> formats;
+};
+
+int main(int argc, char* argv[]) {
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <log_file.bin>" << std::endl;
+		return 1;
+	}
+	BinaryLogReader reader(argv[1]);
+	if (!reader.readHeader()) {
+		std::cerr << argv[1] << " is not a binary log file" << std::endl;
+		return 1;
+	}
+	std::string text;
+	while (reader.next(text)) {
+		std::cout << text << '\n';
+	}
+	return 0;
+}
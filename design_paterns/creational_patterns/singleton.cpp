@@ -21,7 +21,186 @@
 #include <ctime>
 
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+#include <cstddef>
+#include <deque>
+#include <array>
+#include <functional>
+#include <system_error>
+#include <cerrno>
+#include <filesystem>
+#include <tuple>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// The text std::ctime() gives ("Wed Jun 30 21:49:08 1993\n"), formatted into a local buffer: ctime() returns a
+// shared static one, which the asynchronous writer thread and the logging threads would race on.
+std::string formatTime(std::time_t time) {
+	std::tm parts;
+	if (::localtime_r(&time, &parts) == nullptr) return "??? ??? ?? ??:??:?? ????\n";
+	char text[64];
+	return std::string(text, std::strftime(text, sizeof(text), "%a %b %e %H:%M:%S %Y\n", &parts));
+}
+
+
+/////////////////// MappedLogFile Class //////////////////
+// Rotation and retention limits for MappedLogFile.
+struct RotationPolicy {
+	std::size_t segmentSize = 64 * 1024 * 1024;  // bytes preallocated and mapped per segment
+	std::chrono::seconds maxAge{3600};           // start a new segment after this long, even if not full
+	std::size_t maxTotalBytes = 1024 * 1024 * 1024; // oldest segments are deleted beyond this total
+	std::string prefix = "log_";                 // segments are named <prefix><time>_<sequence>.txt
+};
+
+// Log sink that writes into a preallocated, memory-mapped file segment: appending a line is a memcpy, not a
+// write() syscall, and the kernel writes dirty pages back even if the process crashes. Segments rotate on
+// size or age once they hold a line, and are trimmed to their used length when closed; a segment closed
+// without a line in it is deleted, so no empty files are left. Segments left by earlier runs count towards
+// maxTotalBytes, so the cap holds across restarts.
+class MappedLogFile {
+public:
+	explicit MappedLogFile(RotationPolicy policy) : policy(std::move(policy)) {
+		adoptExistingSegments();
+		enforceRetention(0); // trim what earlier runs left behind
+		openSegment();
+	}
+
+	~MappedLogFile() { close(); }
+
+	MappedLogFile(const MappedLogFile&) = delete;
+	MappedLogFile& operator=(const MappedLogFile&) = delete;
+
+	void writeLine(std::string_view timestamp, std::string_view message) { // "<timestamp> : <message>\n"
+		std::lock_guard<std::mutex> lock(mutex);
+		std::size_t length = timestamp.size() + 3 + message.size() + 1;
+		if (data == nullptr) return; // closed
+		bool full = offset + length > policy.segmentSize; // an oversized line still goes into an empty segment
+		bool old = std::chrono::steady_clock::now() - openedAt >= policy.maxAge;
+		if (offset != 0 && (full || old)) { // an empty segment takes the line whatever its age
+			closeSegment();
+			openSegment();
+		}
+		length = std::min(length, policy.segmentSize); // a line longer than a whole segment is truncated
+		char* out = data + offset;
+		char* end = out + length;
+		out = copy(out, end, timestamp);
+		out = copy(out, end, " : ");
+		out = copy(out, end, message);
+		end[-1] = '\n';
+		offset += length;
+	}
+
+	void close() { // Trim and unmap the current segment; later writes are ignored
+		std::lock_guard<std::mutex> lock(mutex);
+		closeSegment();
+	}
+
+private:
+	static char* copy(char* out, char* end, std::string_view text) {
+		std::size_t count = std::min<std::size_t>(text.size(), static_cast<std::size_t>(end - 1 - out)); // keep room for '\n'
+		std::memcpy(out, text.data(), count);
+		return out + count;
+	}
+
+	// Queue the <prefix><time>_<sequence>.txt files of earlier runs, oldest first, and continue their sequence
+	// so that no existing segment is truncated by a new one.
+	void adoptExistingSegments() {
+		namespace fs = std::filesystem;
+		fs::path pattern(policy.prefix);
+		fs::path directory = pattern.has_parent_path() ? pattern.parent_path() : fs::path(".");
+		std::string stem = pattern.filename().string();
+		std::vector<std::tuple<unsigned long long, std::size_t, std::string, std::size_t>> found; // time, sequence, name, size
+		std::error_code error;
+		for (fs::directory_iterator it(directory, error), last; !error && it != last; it.increment(error)) {
+			std::string name = it->path().filename().string();
+			unsigned long long time = 0, number = 0;
+			int consumed = 0;
+			if (name.size() <= stem.size() || name.compare(0, stem.size(), stem) != 0) continue;
+			const char* rest = name.c_str() + stem.size();
+			if (rest[0] < '0' || rest[0] > '9') continue; // sscanf would also accept a sign or spaces
+			if (std::sscanf(rest, "%llu_%llu.txt%n", &time, &number, &consumed) != 2 || rest[consumed] != '\0') continue;
+			std::error_code sizeError;
+			std::uintmax_t size = fs::file_size(it->path(), sizeError);
+			if (sizeError || !it->is_regular_file(sizeError)) continue;
+			std::string filename = pattern.has_parent_path() ? (directory / name).string() : name;
+			found.emplace_back(time, static_cast<std::size_t>(number), std::move(filename), static_cast<std::size_t>(size));
+		}
+		std::sort(found.begin(), found.end());
+		for (auto& [time, number, filename, size] : found) {
+			segments.push_back({std::move(filename), size});
+			sequence = std::max(sequence, number + 1);
+		}
+	}
+
+	void openSegment() {
+		std::string filename = policy.prefix + std::to_string(std::time(nullptr)) + "_" + std::to_string(sequence++) + ".txt";
+		fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + filename);
+		int error = ::posix_fallocate(fd, 0, static_cast<off_t>(policy.segmentSize)); // reserve the blocks up front
+		if (error != 0) {
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), "posix_fallocate " + filename);
+		}
+		void* mapping = ::mmap(nullptr, policy.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) {
+			::close(fd);
+			throw std::system_error(errno, std::generic_category(), "mmap " + filename);
+		}
+		data = static_cast<char*>(mapping);
+		offset = 0;
+		openedAt = std::chrono::steady_clock::now();
+		segments.push_back({filename, policy.segmentSize});
+	}
+
+	void closeSegment() {
+		if (data == nullptr) return;
+		::munmap(data, policy.segmentSize);
+		if (offset != 0 && ::ftruncate(fd, static_cast<off_t>(offset)) != 0) { /* keep the padded file rather than fail */ }
+		::close(fd);
+		data = nullptr;
+		if (offset == 0) { // nothing was written: leave no empty file behind
+			::unlink(segments.back().first.c_str());
+			segments.pop_back();
+		} else {
+			segments.back().second = offset;
+		}
+		enforceRetention();
+	}
+
+	void enforceRetention(std::size_t keep = 1) { // Delete the oldest segments, sparing the newest `keep`, until the total fits in maxTotalBytes
+		std::size_t total = 0;
+		for (const auto& segment : segments) total += segment.second;
+		while (segments.size() > keep && total > policy.maxTotalBytes) {
+			::unlink(segments.front().first.c_str());
+			total -= segments.front().second;
+			segments.pop_front();
+		}
+	}
+
+	RotationPolicy policy;
+	std::mutex mutex;
+	int fd = -1;
+	char* data = nullptr; // current mapping
+	std::size_t offset = 0; // bytes used in the current segment
+	std::size_t sequence = 0;
+	std::chrono::steady_clock::time_point openedAt;
+	std::deque<std::pair<std::string, std::size_t>> segments; // retained files, oldest first, with their sizes
+};
+//////////////////////////////////////////////
 
 /////////////////// Logger Class //////////////////
 class Logger {
@@ -52,14 +231,222 @@ public:
 
 	void log(std::string message) { // Function to add a log message to the log file
 		std::time_t now = std::time(nullptr); // Get the current time
-		std::string timestamp = std::ctime(&now); // Convert the current time to a string
+		if (mapped) { // Rotating memory-mapped segments instead of the single log file
+			mapped->writeLine(formatTime(now), message);
+			return;
+		}
+		std::string timestamp = formatTime(now); // Convert the current time to a string
 		logfile << timestamp << " : " << message << std::endl; // Write the log message to the log file
 	}
+
+	void write(const char* text, std::size_t length) { // Same layout as log(), without building any std::string
+		std::time_t now = std::time(nullptr);
+		if (mapped) {
+			mapped->writeLine(formatTime(now), std::string_view(text, length));
+			return;
+		}
+		logfile << formatTime(now) << " : ";
+		logfile.write(text, length) << std::endl;
+	}
+
+	// From now on write into preallocated, memory-mapped segments rotated and retained according to `policy`.
+	void enableMappedFiles(RotationPolicy policy = RotationPolicy()) {
+		if (mapped) return;
+		logfile.close(); // keeps whatever was logged before the switch
+		mapped.reset(new MappedLogFile(std::move(policy)));
+		std::atexit([] { instance->mapped->close(); }); // trim the last segment to its used length
+	}
+
+private:
+	std::unique_ptr<MappedLogFile> mapped; // Non-null once enableMappedFiles() was called
 };
 
 Logger* Logger::instance = nullptr; // Initialize the static instance of the Logger class to nullptr
 //////////////////////////////////////////////
 
+/////////////////// AsyncLogWriter Class //////////////////
+// What the producers do when the ring buffer is full.
+enum class Backpressure {
+	Block, // yield until the writer thread frees a slot
+	Drop,  // discard the record (counted in droppedCount())
+	Spin   // busy-wait without giving up the CPU (lowest latency, burns a core)
+};
+
+struct LogRecord {
+	std::time_t time;
+	std::string message;
+};
+
+// Bounded multi-producer / single-consumer ring buffer. Every slot carries a sequence number telling
+// producers and the consumer whose turn it is, so pushing and popping never take a lock.
+class LogRingBuffer {
+public:
+	explicit LogRingBuffer(std::size_t capacity) {
+		std::size_t size = 2;
+		while (size < capacity) size <<= 1; // round up to a power of two so positions can be masked
+		mask = size - 1;
+		slots.reset(new Slot[size]);
+		for (std::size_t i = 0; i < size; ++i) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool tryPush(LogRecord& record) { // Called by any thread
+		std::size_t pos = head.load(std::memory_order_relaxed);
+		for (;;) {
+			Slot& slot = slots[pos & mask];
+			std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) { // slot is free for this position: try to claim it
+				if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					slot.record = std::move(record);
+					slot.sequence.store(pos + 1, std::memory_order_release); // publish to the consumer
+					return true;
+				}
+			} else if (diff < 0) { // slot still holds an unread record: buffer is full
+				return false;
+			} else { // another producer claimed this position first
+				pos = head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool tryPop(LogRecord& record) { // Called by the writer thread only
+		Slot& slot = slots[tail & mask];
+		if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+			return false; // empty, or the producer has claimed the slot but not published it yet
+		}
+		record = std::move(slot.record);
+		slot.sequence.store(tail + mask + 1, std::memory_order_release); // hand the slot back to producers
+		++tail;
+		return true;
+	}
+
+	std::size_t claimed() const { return head.load(std::memory_order_acquire); } // positions handed out to producers
+	std::size_t consumed() const { return tail; }                                // positions read by the consumer
+
+private:
+	struct alignas(64) Slot { // one cache line per slot so neighbouring producers do not false-share
+		std::atomic<std::size_t> sequence;
+		LogRecord record;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	std::size_t mask = 0;
+	alignas(64) std::atomic<std::size_t> head{0}; // next position to claim (producers)
+	alignas(64) std::size_t tail = 0;             // next position to read (consumer)
+};
+
+// Owns the ring buffer and the dedicated thread that drains it into the log file in batches.
+class AsyncLogWriter {
+public:
+	AsyncLogWriter(std::ostream& out, std::size_t capacity, Backpressure policy)
+		: out(out), queue(capacity), policy(policy) {
+		writer = std::thread(&AsyncLogWriter::run, this);
+	}
+
+	~AsyncLogWriter() { close(); }
+
+	AsyncLogWriter(const AsyncLogWriter&) = delete;
+	AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+	// Returns false only once close() has started; the caller must then log some other way. The record is
+	// moved from only when it is accepted, so a rejected record can still be logged synchronously.
+	// A record rejected by Backpressure::Drop still counts as handled and returns true.
+	bool push(LogRecord& record) {
+		activeProducers.fetch_add(1); // seq_cst: pairs with close() so no push can slip past the final drain
+		if (closed.load()) {
+			activeProducers.fetch_sub(1);
+			return false;
+		}
+		while (!queue.tryPush(record)) {
+			if (policy == Backpressure::Drop) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+			wake.notify_one(); // make sure the writer is not sleeping on a full buffer
+			if (policy == Backpressure::Block) {
+				std::this_thread::yield();
+			}
+		}
+		activeProducers.fetch_sub(1, std::memory_order_release);
+		if (writerIdle.load(std::memory_order_relaxed)) {
+			wake.notify_one();
+		}
+		return true;
+	}
+
+	// Blocks until every record pushed before the call has been written and flushed to the file.
+	void flush() {
+		std::size_t target = queue.claimed();
+		while (written.load(std::memory_order_acquire) < target) {
+			wake.notify_one();
+			std::this_thread::yield();
+		}
+	}
+
+	// Stops accepting records, drains whatever is left and joins the writer thread. Idempotent.
+	void close() {
+		closed.store(true);
+		while (activeProducers.load() != 0) { // wait for producers that got in before the flag flipped
+			std::this_thread::yield();
+		}
+		stopping.store(true, std::memory_order_release);
+		wake.notify_one();
+		if (writer.joinable()) {
+			writer.join();
+		}
+	}
+
+	std::size_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr std::size_t batchSize = 256; // records written between two flushes of the file
+
+	void run() {
+		LogRecord record;
+		std::time_t lastTime = -1;
+		std::string timestamp;
+		for (;;) {
+			std::size_t count = 0;
+			while (count < batchSize && queue.tryPop(record)) {
+				if (record.time != lastTime) { // format the time only once per second instead of once per record
+					lastTime = record.time;
+					timestamp = formatTime(lastTime);
+				}
+				out << timestamp << " : " << record.message << '\n';
+				++count;
+			}
+			if (count != 0) {
+				out.flush();
+				written.store(queue.consumed(), std::memory_order_release);
+				continue;
+			}
+			if (stopping.load(std::memory_order_acquire) && queue.consumed() == queue.claimed()) {
+				return; // every claimed slot has been drained
+			}
+			std::unique_lock<std::mutex> lock(wakeMutex); // only the idle writer ever touches this mutex
+			writerIdle.store(true, std::memory_order_relaxed);
+			wake.wait_for(lock, std::chrono::milliseconds(1));
+			writerIdle.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	std::ostream& out;
+	LogRingBuffer queue;
+	Backpressure policy;
+	std::thread writer;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	std::atomic<bool> writerIdle{false};
+	std::atomic<bool> stopping{false};
+	std::atomic<bool> closed{false};
+	std::atomic<std::size_t> activeProducers{0};
+	std::atomic<std::size_t> written{0};
+	std::atomic<std::size_t> dropped{0};
+};
+//////////////////////////////////////////////
+
 /////////////////// LoggerSafeThread Class //////////////////
 class LoggerSafeThread {
 private:
@@ -70,8 +457,8 @@ private:
 	LoggerSafeThread() { // Private constructor
 		// Get the current time to use in the log file name
 		std::time_t now = std::time(nullptr);
-		std::string filename = "log_" + std::to_string(now) + ".txt";
-		logfile.open(filename); // Open the log file for writing
+		std::string filename = "log_safe_" + std::to_string(now) + ".txt";
+		logfile.open(filename); // Own file: Logger truncates and writes log_<time>.txt at its own offset
 	}
 
 	~LoggerSafeThread() { delete instance;}// Private destructor
@@ -90,11 +477,63 @@ public:
 	}
 
 	void log(std::string message) { // Function to add a log message to the log file
-		std::lock_guard<std::mutex> lock(mutex); // Lock the mutex to ensure thread-safety
-		std::time_t now = std::time(nullptr); // Get the current time
-		std::string timestamp = std::ctime(&now); // Convert the current time to a string
-		logfile << timestamp << " : " << message << std::endl; // Write the log message to the log file
+		LogRecord record{std::time(nullptr), std::move(message)}; // Get the current time
+		if (AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire)) { // Async mode: no lock, no formatting
+			if (writer->push(record)) return;
+		}
+		std::unique_lock<std::mutex> lock(mutex); // Lock the mutex to ensure thread-safety
+		while (AsyncLogWriter* writer = asyncWriter.load(std::memory_order_relaxed)) { // enableAsync() won the race for the lock
+			lock.unlock();
+			if (writer->push(record)) return;
+			lock.lock(); // shutdown() closed the writer meanwhile: it clears asyncWriter before releasing the lock
+		}
+		std::string timestamp = formatTime(record.time); // Convert the current time to a string
+		logfile << timestamp << " : " << record.message << std::endl; // Write the log message to the log file
+	}
+
+	// Switch to asynchronous mode: log() pushes records into a lock-free ring buffer of `capacity` slots
+	// and a dedicated writer thread formats and writes them in batches. Pending records are drained at exit.
+	void enableAsync(std::size_t capacity = 8192, Backpressure policy = Backpressure::Block) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (asyncWriter.load(std::memory_order_relaxed) != nullptr) return;
+		logfile.flush(); // last touch from this side: from here on only the writer thread uses logfile
+		asyncOwner.reset(new AsyncLogWriter(logfile, capacity, policy));
+		asyncWriter.store(asyncOwner.get(), std::memory_order_release);
+		static bool registered = false;
+		if (!registered) {
+			registered = true;
+			std::atexit([] { instance->shutdown(); }); // guarantee nothing is lost when main returns
+		}
+	}
+
+	void flush() { // Block until every message logged so far is in the file
+		std::unique_lock<std::mutex> lock(mutex);
+		if (AsyncLogWriter* writer = asyncWriter.load(std::memory_order_relaxed)) {
+			lock.unlock();
+			writer->flush(); // the writer thread owns logfile in async mode and flushes it itself
+			return;
+		}
+		logfile.flush();
+	}
+
+	void shutdown() { // Drain the async buffer, stop the writer thread and fall back to synchronous logging
+		std::lock_guard<std::mutex> lock(mutex); // synchronous fallbacks wait here until the drain is over
+		if (AsyncLogWriter* writer = asyncWriter.load(std::memory_order_relaxed)) {
+			writer->close();
+			asyncWriter.store(nullptr, std::memory_order_release);
+			// asyncOwner stays alive: a producer may still hold the raw pointer, push() then just returns false
+		}
+		logfile.flush();
 	}
+
+	std::size_t droppedCount() const { // Records discarded by Backpressure::Drop
+		AsyncLogWriter* writer = asyncOwner.get();
+		return writer ? writer->droppedCount() : 0;
+	}
+
+private:
+	std::unique_ptr<AsyncLogWriter> asyncOwner; // Owns the async backend once enableAsync() was called
+	std::atomic<AsyncLogWriter*> asyncWriter{nullptr}; // Non-null while async mode is active
 };
 
 LoggerSafeThread* LoggerSafeThread::instance = nullptr; // Initialize the static instance of the LoggerSafeThread class to nullptr
@@ -102,7 +541,528 @@ std::mutex LoggerSafeThread::mutex; // Initialize the static mutex to unlock
 //////////////////////////////////////////////
 
 
-int main() {
+/////////////////// log<Level> //////////////////
+// Type-safe, level-filtered logging (see error_log in others/templates_variadic/003_variadic_functions.cpp):
+// the format string is checked against the argument types at compile time, calls below minLevel compile to
+// nothing, and the enabled path formats into a stack buffer and hands it to the installed sink.
+
+enum class Level { Debug, Info, Warning, Error };
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1 // Info; build with -DLOG_MIN_LEVEL=0 to keep Debug calls
+#endif
+constexpr Level minLevel = static_cast<Level>(LOG_MIN_LEVEL);
+
+constexpr const char* levelName(Level level)
+{
+	switch (level) {
+	case Level::Debug: return "DEBUG";
+	case Level::Info: return "INFO";
+	case Level::Warning: return "WARNING";
+	default: return "ERROR";
+	}
+}
+
+enum class ArgKind { Integer, Character, Floating, String, Pointer, Unsupported };
+
+struct ArgInfo {
+	ArgKind kind;
+	std::size_t size;
+};
+
+template <typename T>
+consteval ArgInfo argInfo()
+{
+	using U = std::decay_t<T>; // string literals arrive as char arrays
+	if constexpr (std::is_same_v<U, char>) return {ArgKind::Character, sizeof(U)};
+	else if constexpr (std::is_integral_v<U>) return {ArgKind::Integer, sizeof(U)};
+	else if constexpr (std::is_floating_point_v<U>) return {ArgKind::Floating, sizeof(U)};
+	else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> || std::is_same_v<U, std::string>) return {ArgKind::String, sizeof(U)};
+	else if constexpr (std::is_pointer_v<U>) return {ArgKind::Pointer, sizeof(U)};
+	else return {ArgKind::Unsupported, sizeof(U)};
+}
+
+consteval bool integerLengthMatches(std::string_view modifier, std::size_t size)
+{
+	if (modifier.empty() || modifier == "h" || modifier == "hh") return size <= sizeof(int);
+	if (modifier == "l") return size == sizeof(long);
+	if (modifier == "ll") return size == sizeof(long long);
+	if (modifier == "z") return size == sizeof(std::size_t);
+	if (modifier == "j") return size == sizeof(std::intmax_t);
+	if (modifier == "t") return size == sizeof(std::ptrdiff_t);
+	return false;
+}
+
+// Walks the printf conversions and checks each one against the next argument.
+template <typename... Args>
+consteval bool formatMatches(std::string_view format)
+{
+	constexpr ArgInfo args[] = {argInfo<Args>()..., ArgInfo{ArgKind::Unsupported, 0}}; // sentinel keeps the array non-empty
+	constexpr std::size_t count = sizeof...(Args);
+	std::size_t next = 0;
+	for (std::size_t i = 0; i < format.size(); ++i) {
+		if (format[i] != '%') continue;
+		if (++i == format.size()) return false;
+		if (format[i] == '%') continue;
+		while (i < format.size() && std::string_view("-+ #0").find(format[i]) != std::string_view::npos) ++i; // flags
+		while (i < format.size() && format[i] >= '0' && format[i] <= '9') ++i; // width ('*' is not supported)
+		if (i < format.size() && format[i] == '.') {
+			++i;
+			while (i < format.size() && format[i] >= '0' && format[i] <= '9') ++i; // precision
+		}
+		std::size_t modifierStart = i;
+		while (i < format.size() && std::string_view("hljztL").find(format[i]) != std::string_view::npos) ++i;
+		std::string_view modifier = format.substr(modifierStart, i - modifierStart);
+		if (i == format.size() || next == count) return false; // truncated conversion or too few arguments
+		ArgInfo arg = args[next++];
+		switch (format[i]) {
+		case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+			if ((arg.kind != ArgKind::Integer && arg.kind != ArgKind::Character) || !integerLengthMatches(modifier, arg.size)) return false;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			if (arg.kind != ArgKind::Floating) return false;
+			if (modifier == "L" ? arg.size != sizeof(long double) : (arg.size > sizeof(double) || (!modifier.empty() && modifier != "l"))) return false;
+			break;
+		case 'c':
+			if ((arg.kind != ArgKind::Character && arg.kind != ArgKind::Integer) || !modifier.empty() || arg.size > sizeof(int)) return false;
+			break;
+		case 's':
+			if (arg.kind != ArgKind::String || !modifier.empty()) return false;
+			break;
+		case 'p':
+			if ((arg.kind != ArgKind::Pointer && arg.kind != ArgKind::String) || !modifier.empty()) return false;
+			break;
+		default:
+			return false;
+		}
+	}
+	return next == count; // too many arguments is an error as well
+}
+
+// Only constructible from a string literal that matches Args; evaluated by the compiler (consteval).
+template <typename... Args>
+class FormatString {
+public:
+	template <std::size_t N>
+	consteval FormatString(const char (&format)[N]) : text(format)
+	{
+		if (!formatMatches<Args...>(std::string_view(format, N - 1))) {
+			throw "log: format string does not match the argument types"; // not a constant expression -> compile error
+		}
+	}
+
+	const char* text;
+};
+
+// Where formatted lines go. The text is only valid for the duration of the call (it lives on the caller's stack).
+using LogSink = void (*)(Level level, const char* text, std::size_t length);
+
+void stderrSink(Level, const char* text, std::size_t length)
+{
+	std::fwrite(text, 1, length, stderr);
+	std::fputc('\n', stderr);
+}
+
+std::atomic<LogSink> logSink{stderrSink};
+
+void setLogSink(LogSink sink)
+{
+	logSink.store(sink, std::memory_order_release);
+}
+
+template <typename T>
+auto printfArg(const T& value)
+{
+	if constexpr (std::is_same_v<T, std::string>) return value.c_str();
+	else return value; // arrays decay to pointers here
+}
+
+// Calling log<Level> directly still evaluates the arguments of a disabled call; go through LOG below when
+// they have side effects or cost something to compute.
+template <Level level, typename... Args>
+void log(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+	if constexpr (level >= minLevel) {
+		char buffer[512]; // longer messages are truncated
+		int prefix = std::snprintf(buffer, sizeof(buffer), "[%s]: ", levelName(level));
+		int body = std::snprintf(buffer + prefix, sizeof(buffer) - prefix, format.text, printfArg(args)...);
+		std::size_t length = std::min(static_cast<std::size_t>(prefix + (body > 0 ? body : 0)), sizeof(buffer) - 1);
+		logSink.load(std::memory_order_acquire)(level, buffer, length);
+	}
+}
+
+// LOG(Debug, "x=%d", expensive()) puts the level test at the call site, so a call below minLevel is still
+// type-checked but none of its arguments are evaluated.
+#define LOG(level, format, ...) \
+	do { \
+		if constexpr (Level::level >= minLevel) log<Level::level>(format, ##__VA_ARGS__); \
+	} while (0)
+
+void loggerSink(Level, const char* text, std::size_t length) // setLogSink(loggerSink) routes log<Level> into Logger
+{
+	Logger::getInstance()->write(text, length);
+}
+//////////////////////////////////////////////
+
+/////////////////// BinaryLogger Class //////////////////
+// Deferred-format logging: the hot path stores only a call-site format id, a raw steady_clock timestamp and
+// the packed arguments into a thread-local buffer. Turning records back into "timestamp : message" text is
+// the job of the offline tool in binary_log_decoder.cpp.
+//
+// File layout (native byte order):
+//   header : "BLOG" | u32 version | i64 wall clock ns at start | i64 steady clock ns at start
+//   kind 1 : u8 1 | u32 id | u16 signature length | signature | u32 format length | format    (format definition)
+//   kind 2 : u8 2 | u32 id | i64 steady clock ns | packed arguments                          (log entry)
+// Argument signature codes: 'i' int64, 'u' uint64, 'c' char (stored as int64), 'd' double, 's' u32 length + bytes.
+
+// Log through a call-site-unique lambda type so that each BINLOG line owns its own format id. The id is a
+// function-local static, registered (and written to the file) the first time that line runs, not a compile-time
+// constant. The format string itself is checked against the argument types at compile time, as for log<Level>.
+#define BINLOG(format, ...) BinaryLogger::log<decltype([] {})>(format, ##__VA_ARGS__)
+
+class BinaryLogger {
+private:
+	static constexpr std::size_t bufferSize = 64 * 1024; // per-thread staging buffer
+	static constexpr std::uint32_t maxStringLength = 4096; // longer string arguments are truncated
+	static constexpr std::uint8_t formatRecord = 1;
+	static constexpr std::uint8_t entryRecord = 2;
+
+	std::FILE* logfile;
+	std::mutex mutex; // taken only to register a format or to append a full thread buffer
+	std::uint32_t nextId = 0;
+	static BinaryLogger* instance; // Static instance of the BinaryLogger class
+	static std::once_flag created;
+
+	struct ThreadBuffer {
+		char data[bufferSize];
+		std::size_t size = 0;
+		~ThreadBuffer() { if (size != 0) instance->append(data, size); } // thread exit: nothing left behind
+	};
+
+	BinaryLogger() { // Private constructor
+		std::time_t now = std::time(nullptr);
+		std::string filename = "log_" + std::to_string(now) + ".bin";
+		logfile = std::fopen(filename.c_str(), "wb");
+		std::int64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		std::int64_t steady = steadyNow();
+		std::uint32_t version = 1;
+		std::fwrite("BLOG", 1, 4, logfile);
+		std::fwrite(&version, sizeof(version), 1, logfile);
+		std::fwrite(&wall, sizeof(wall), 1, logfile);
+		std::fwrite(&steady, sizeof(steady), 1, logfile);
+	}
+
+	BinaryLogger(BinaryLogger &other) = delete; // Singletons should not be cloneable.
+	void operator=(const BinaryLogger &) = delete; // Singletons should not be assignable
+
+	static std::int64_t steadyNow() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static ThreadBuffer& threadBuffer() {
+		thread_local ThreadBuffer buffer;
+		return buffer;
+	}
+
+	template <typename T>
+	static constexpr char typeCode() {
+		using U = std::decay_t<T>;
+		if constexpr (std::is_same_v<U, char>) return 'c';
+		else if constexpr (std::is_same_v<U, bool>) return 'u';
+		else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) return 'i';
+		else if constexpr (std::is_integral_v<U>) return 'u';
+		else if constexpr (std::is_floating_point_v<U>) return 'd';
+		else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> || std::is_same_v<U, std::string>) return 's';
+		else static_assert(sizeof(U) == 0, "BINLOG argument must be an integer, a floating point value or a string");
+	}
+
+	template <typename T>
+	static std::size_t packedSize(const T& value) {
+		if constexpr (typeCode<T>() == 's') {
+			return sizeof(std::uint32_t) + std::min<std::size_t>(std::string_view(value).size(), maxStringLength);
+		} else {
+			return 8;
+		}
+	}
+
+	template <typename T>
+	static char* pack(char* out, const T& value) {
+		constexpr char code = typeCode<T>();
+		if constexpr (code == 's') {
+			std::string_view text(value);
+			std::uint32_t length = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), maxStringLength));
+			std::memcpy(out, &length, sizeof(length));
+			std::memcpy(out + sizeof(length), text.data(), length);
+			return out + sizeof(length) + length;
+		} else if constexpr (code == 'd') {
+			double number = static_cast<double>(value);
+			std::memcpy(out, &number, 8);
+			return out + 8;
+		} else if constexpr (code == 'u') {
+			std::uint64_t number = static_cast<std::uint64_t>(value);
+			std::memcpy(out, &number, 8);
+			return out + 8;
+		} else {
+			std::int64_t number = static_cast<std::int64_t>(value);
+			std::memcpy(out, &number, 8);
+			return out + 8;
+		}
+	}
+
+	void append(const char* data, std::size_t size) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::fwrite(data, 1, size, logfile);
+	}
+
+	template <typename... Args>
+	std::uint32_t registerFormat(const char* format) { // once per call site
+		static constexpr char signature[] = {typeCode<Args>()..., '\0'};
+		std::lock_guard<std::mutex> lock(mutex);
+		std::uint32_t id = nextId++;
+		std::uint16_t signatureLength = sizeof...(Args);
+		std::uint32_t formatLength = static_cast<std::uint32_t>(std::strlen(format));
+		// Written straight to the file, so the definition always precedes any buffered entry using the id
+		std::fwrite(&formatRecord, 1, 1, logfile);
+		std::fwrite(&id, sizeof(id), 1, logfile);
+		std::fwrite(&signatureLength, sizeof(signatureLength), 1, logfile);
+		std::fwrite(signature, 1, signatureLength, logfile);
+		std::fwrite(&formatLength, sizeof(formatLength), 1, logfile);
+		std::fwrite(format, 1, formatLength, logfile);
+		return id;
+	}
+
+	template <typename... Args>
+	static char* encode(char* out, std::uint32_t id, std::int64_t timestamp, const Args&... args) {
+		*out++ = static_cast<char>(entryRecord);
+		std::memcpy(out, &id, sizeof(id));
+		out += sizeof(id);
+		std::memcpy(out, &timestamp, sizeof(timestamp));
+		out += sizeof(timestamp);
+		((out = pack(out, args)), ...);
+		return out;
+	}
+
+	template <typename... Args>
+	void write(std::uint32_t id, const Args&... args) {
+		std::int64_t timestamp = steadyNow();
+		ThreadBuffer& buffer = threadBuffer();
+		std::size_t needed = 1 + sizeof(id) + sizeof(timestamp) + (std::size_t{0} + ... + packedSize(args));
+		if (buffer.size + needed > bufferSize) {
+			append(buffer.data, buffer.size);
+			buffer.size = 0;
+		}
+		if (needed > bufferSize) { // does not fit even an empty buffer (many long strings): straight to the file
+			std::unique_ptr<char[]> record(new char[needed]);
+			append(record.get(), static_cast<std::size_t>(encode(record.get(), id, timestamp, args...) - record.get()));
+			return;
+		}
+		char* out = encode(buffer.data + buffer.size, id, timestamp, args...);
+		buffer.size = static_cast<std::size_t>(out - buffer.data);
+	}
+
+public:
+	static BinaryLogger* getInstance() { // Static function to get the instance of the BinaryLogger class
+		std::call_once(created, [] { instance = new BinaryLogger(); }); // thread-safe, one atomic load once created
+		return instance;
+	}
+
+	// Use through BINLOG("format", args...): printf-style format, integer / floating point / string arguments.
+	// CallSite is a type unique to each BINLOG line, so each line gets its own `id` static.
+	template <typename CallSite, typename... Args>
+	static void log(FormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+		BinaryLogger* logger = getInstance();
+		static const std::uint32_t id = logger->registerFormat<Args...>(format.text);
+		logger->write(id, args...);
+	}
+
+	void flush() { // Push the calling thread's buffer to the file (other threads flush when they exit)
+		ThreadBuffer& buffer = threadBuffer();
+		std::lock_guard<std::mutex> lock(mutex);
+		std::fwrite(buffer.data, 1, buffer.size, logfile);
+		buffer.size = 0;
+		std::fflush(logfile);
+	}
+};
+
+BinaryLogger* BinaryLogger::instance = nullptr; // Initialize the static instance of the BinaryLogger class to nullptr
+std::once_flag BinaryLogger::created;
+//////////////////////////////////////////////
+
+////////////////////////// Benchmark //////////////////////////
+// ./singleton --bench [max threads] [messages per thread] [result.json]
+// Drives every BenchmarkTarget with 1, 2, 4 ... max threads and reports throughput plus per-call latency
+// percentiles. The JSON file is meant to be kept per release so regressions show up as a diff.
+
+// HDR-style latency histogram: 32 linear sub-buckets per power of two, so every recorded value is
+// within ~3% of its bucket while the whole 1 ns .. 2^63 ns range fits in a fixed array.
+class LatencyHistogram {
+public:
+	void record(std::uint64_t nanoseconds) {
+		++counts[indexOf(nanoseconds)];
+		++total;
+		maximum = std::max(maximum, nanoseconds);
+	}
+
+	void merge(const LatencyHistogram& other) {
+		for (std::size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+		total += other.total;
+		maximum = std::max(maximum, other.maximum);
+	}
+
+	std::uint64_t percentile(double fraction) const { // upper edge of the bucket holding the requested rank
+		std::uint64_t rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < counts.size(); ++i) {
+			seen += counts[i];
+			if (seen > rank) return std::min(valueOf(i + 1) - 1, maximum);
+		}
+		return maximum;
+	}
+
+	std::uint64_t max() const { return maximum; }
+
+private:
+	static constexpr int subBucketBits = 5;
+	static constexpr std::uint64_t subBuckets = 1u << subBucketBits;
+
+	static std::size_t indexOf(std::uint64_t value) {
+		if (value < subBuckets) return static_cast<std::size_t>(value);
+		int exponent = 63 - __builtin_clzll(value);
+		return static_cast<std::size_t>((exponent - subBucketBits + 1) * subBuckets + ((value >> (exponent - subBucketBits)) & (subBuckets - 1)));
+	}
+
+	static std::uint64_t valueOf(std::size_t index) { // lowest value that lands in bucket `index`
+		if (index < subBuckets) return index;
+		int exponent = static_cast<int>(index / subBuckets) + subBucketBits - 1;
+		return (subBuckets + index % subBuckets) << (exponent - subBucketBits);
+	}
+
+	std::array<std::uint64_t, (64 - subBucketBits + 1) * subBuckets> counts{};
+	std::uint64_t total = 0;
+	std::uint64_t maximum = 0;
+};
+
+// One logging configuration under test. Adding a new sink or async mode is one more entry in benchmarkTargets().
+struct BenchmarkTarget {
+	std::string name;
+	bool threadSafe;                               // Logger is not, so it only runs single-threaded
+	std::function<void()> setUp;                   // switch the singleton into the mode under test
+	std::function<void(const std::string&)> log;   // the call being timed
+	std::function<void()> drain;                   // wait until everything is on disk (async modes)
+};
+
+std::vector<BenchmarkTarget> benchmarkTargets() {
+	return {
+		{"Logger/ofstream", false, [] {}, [](const std::string& m) { Logger::getInstance()->log(m); }, [] {}},
+		{"Logger/mmap", false, [] { Logger::getInstance()->enableMappedFiles(); },
+			[](const std::string& m) { Logger::getInstance()->log(m); }, [] {}},
+		{"LoggerSafeThread/sync", true, [] {}, [](const std::string& m) { LoggerSafeThread::getInstance()->log(m); }, [] {}},
+		{"LoggerSafeThread/async", true, [] { LoggerSafeThread::getInstance()->enableAsync(65536, Backpressure::Block); },
+			[](const std::string& m) { LoggerSafeThread::getInstance()->log(m); },
+			[] { LoggerSafeThread::getInstance()->flush(); }},
+		{"BINLOG", true, [] {}, [](const std::string& m) { BINLOG("%s", m); }, [] { BinaryLogger::getInstance()->flush(); }},
+	};
+}
+
+struct BenchmarkResult {
+	std::string target;
+	unsigned threads;
+	std::uint64_t messages;
+	std::uint64_t bytes;
+	double seconds;
+	LatencyHistogram latency;
+};
+
+std::vector<std::string> benchmarkMessages(unsigned seed) { // realistic mix: mostly short lines, some long ones
+	static const std::size_t sizes[] = {48, 48, 96, 96, 96, 160, 160, 256, 512, 1024};
+	std::vector<std::string> messages;
+	for (std::size_t i = 0; i < 64; ++i) {
+		std::string message = "req=" + std::to_string(seed * 1000 + i) + " user=alice path=/api/v1/orders status=200 ";
+		message.resize(sizes[i % 10], 'x');
+		messages.push_back(message);
+	}
+	return messages;
+}
+
+BenchmarkResult runBenchmark(const BenchmarkTarget& target, unsigned threads, std::uint64_t messagesPerThread) {
+	target.setUp();
+	BenchmarkResult result{target.name, threads, messagesPerThread * threads, 0, 0.0, LatencyHistogram()};
+	std::vector<LatencyHistogram> histograms(threads);
+	std::vector<std::uint64_t> bytes(threads, 0);
+	std::vector<std::thread> workers;
+	std::atomic<unsigned> ready{0};
+	std::atomic<bool> go{false};
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			std::vector<std::string> messages = benchmarkMessages(t);
+			ready.fetch_add(1);
+			while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+			for (std::uint64_t i = 0; i < messagesPerThread; ++i) {
+				const std::string& message = messages[i % messages.size()];
+				auto start = std::chrono::steady_clock::now();
+				target.log(message);
+				auto elapsed = std::chrono::steady_clock::now() - start;
+				histograms[t].record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+				bytes[t] += message.size();
+			}
+		});
+	}
+	while (ready.load() != threads) std::this_thread::yield();
+	auto start = std::chrono::steady_clock::now();
+	go.store(true, std::memory_order_release);
+	for (auto& worker : workers) worker.join();
+	target.drain(); // throughput includes the time to get async records on disk
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (unsigned t = 0; t < threads; ++t) {
+		result.latency.merge(histograms[t]);
+		result.bytes += bytes[t];
+	}
+	return result;
+}
+
+void writeBenchmarkJson(const std::vector<BenchmarkResult>& results, const std::string& filename) {
+	std::ofstream json(filename);
+	json << "{\n  \"timestamp\": " << std::time(nullptr) << ",\n  \"results\": [";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& r = results[i];
+		json << (i ? "," : "") << "\n    {\"target\": \"" << r.target << "\", \"threads\": " << r.threads
+			 << ", \"messages\": " << r.messages << ", \"bytes\": " << r.bytes << ", \"seconds\": " << r.seconds
+			 << ", \"messages_per_sec\": " << r.messages / r.seconds << ", \"bytes_per_sec\": " << r.bytes / r.seconds
+			 << ", \"latency_ns\": {\"p50\": " << r.latency.percentile(0.5) << ", \"p99\": " << r.latency.percentile(0.99)
+			 << ", \"p99.9\": " << r.latency.percentile(0.999) << ", \"max\": " << r.latency.max() << "}}";
+	}
+	json << "\n  ]\n}\n";
+}
+
+void runBenchmarkSuite(unsigned maxThreads, std::uint64_t messagesPerThread, const std::string& jsonFile) {
+	std::vector<BenchmarkResult> results;
+	std::printf("%-24s %7s %14s %12s %9s %9s %9s\n", "target", "threads", "msgs/s", "MB/s", "p50 ns", "p99 ns", "p99.9 ns");
+	for (const BenchmarkTarget& target : benchmarkTargets()) {
+		for (unsigned threads = 1; threads <= (target.threadSafe ? maxThreads : 1); threads *= 2) {
+			BenchmarkResult r = runBenchmark(target, threads, messagesPerThread);
+			std::printf("%-24s %7u %14.0f %12.1f %9llu %9llu %9llu\n", r.target.c_str(), r.threads, r.messages / r.seconds,
+						r.bytes / r.seconds / 1e6, static_cast<unsigned long long>(r.latency.percentile(0.5)),
+						static_cast<unsigned long long>(r.latency.percentile(0.99)),
+						static_cast<unsigned long long>(r.latency.percentile(0.999)));
+			results.push_back(std::move(r));
+		}
+	}
+	writeBenchmarkJson(results, jsonFile);
+	std::cout << "Results written to " << jsonFile << std::endl;
+}
+//////////////////////////////////////////////
+
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string(argv[1]) == "--bench") { // runs before the demo so every target starts from its default mode
+		unsigned maxThreads = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+		std::uint64_t messagesPerThread = argc > 3 ? std::stoull(argv[3]) : 50000;
+		std::string jsonFile = argc > 4 ? argv[4] : "bench_" + std::to_string(std::time(nullptr)) + ".json";
+		runBenchmarkSuite(maxThreads, messagesPerThread, jsonFile);
+		return 0;
+	}
 
 	Logger* logger = Logger::getInstance(); // Get the singleton instance of the Logger class
 	logger->log("This is a log message."); // Add a log message to the log file
@@ -113,5 +1073,41 @@ int main() {
 	// Wed Mar 15 08:01:10 2023
 	//  : This is another msg
 
+	LoggerSafeThread* safeLogger = LoggerSafeThread::getInstance();
+	safeLogger->enableAsync(4096, Backpressure::Block); // producers only push into a lock-free ring buffer
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 4; ++t) {
+		workers.emplace_back([safeLogger, t] {
+			for (int i = 0; i < 3; ++i) {
+				safeLogger->log("worker " + std::to_string(t) + " message " + std::to_string(i));
+			}
+		});
+	}
+	for (auto& worker : workers) worker.join();
+	safeLogger->flush(); // all 12 messages are in log_safe_<time>.txt now; the rest would be drained at exit anyway
+
+	BINLOG("Path (%s) not found at %s", "c:\\user\\Document", "2022-03-11 09:38"); // log_<time>.bin, tens of ns per call
+	BINLOG("An error has occured %d times due to %s", 3, "Exception");
+	BinaryLogger::getInstance()->flush();
+	// $ ./binary_log_decoder log_1678863670.bin
+	// Wed Mar 15 08:01:10 2023
+	//  : Path (c:\user\Document) not found at 2022-03-11 09:38
+	// Wed Mar 15 08:01:10 2023
+	//  : An error has occured 3 times due to Exception
+
+	setLogSink(loggerSink); // log<Level> now writes into the Logger singleton
+	LOG(Warning, "Disk usage at %d%% on %s", 91, "/var");
+	int cacheProbes = 0;
+	LOG(Debug, "Cache hit ratio %f", (++cacheProbes, 0.93)); // below minLevel: compiled away, cacheProbes stays 0
+	/////// log_1678863670.txt //////
+	// Wed Mar 15 08:01:10 2023
+	//  : [WARNING]: Disk usage at 91% on /var
+
+	RotationPolicy rotation;
+	rotation.segmentSize = 1024 * 1024; // 1 MB segments, rotated at least hourly
+	rotation.maxTotalBytes = 8 * 1024 * 1024; // never keep more than 8 MB of logs on disk
+	logger->enableMappedFiles(rotation);
+	logger->log("This message is copied into a memory-mapped segment."); // log_1678863670_0.txt
+
 	return 0;
 }
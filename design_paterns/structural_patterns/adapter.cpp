@@ -15,13 +15,156 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <tuple>
+#include <type_traits>
+#include <charconv>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// XML escaping: the five characters that are special in markup become entity references. Text is scanned
+// 16 bytes at a time for them, so the plain runs in between are measured and copied in bulk.
+const char *xmlEntity(char c)
+{
+	switch (c)
+	{
+	case '<': return "&lt;";
+	case '>': return "&gt;";
+	case '&': return "&amp;";
+	case '"': return "&quot;";
+	case '\'': return "&apos;";
+	default: return nullptr;
+	}
+}
+
+const char *findXmlSpecial(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+	const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'), amp = _mm_set1_epi8('&');
+	const __m128i quot = _mm_set1_epi8('"'), apos = _mm_set1_epi8('\'');
+	for (; p + 16 <= end; p += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)),
+									_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, quot)), _mm_cmpeq_epi8(chunk, apos)));
+		int mask = _mm_movemask_epi8(hits);
+		if (mask != 0)
+			return p + __builtin_ctz(static_cast<unsigned>(mask));
+	}
+#endif
+	while (p < end && xmlEntity(*p) == nullptr)
+		++p;
+	return p;
+}
+
+std::size_t xmlEscapedSize(std::string_view text)
+{
+	std::size_t size = text.size();
+	const char *end = text.data() + text.size();
+	for (const char *p = findXmlSpecial(text.data(), end); p != end; p = findXmlSpecial(p + 1, end))
+		size += std::strlen(xmlEntity(*p)) - 1;
+	return size;
+}
+
+char *writeXmlEscaped(char *out, std::string_view text) // returns the end of what was written
+{
+	const char *p = text.data();
+	const char *end = p + text.size();
+	for (;;)
+	{
+		const char *special = findXmlSpecial(p, end);
+		std::memcpy(out, p, special - p);
+		out += special - p;
+		if (special == end)
+			return out;
+		const char *entity = xmlEntity(*special);
+		std::size_t length = std::strlen(entity);
+		std::memcpy(out, entity, length);
+		out += length;
+		p = special + 1;
+	}
+}
+
+// XML element names: map keys are arbitrary strings, but an element name has to match the XML Name
+// production. ASCII characters outside it are written as _xHHHH_ (the XmlConvert.EncodeName convention), as
+// is a '_' that would otherwise read as the start of such an escape, so distinct keys stay distinct.
+// Non-ASCII bytes are passed through; an empty key becomes "_".
+bool isXmlNameChar(char c, bool first)
+{
+	if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80)
+		return true;
+	return !first && ((c >= '0' && c <= '9') || c == '-' || c == '.'); // ':' is left out: it would read as a namespace prefix
+}
+
+bool needsNameEscape(std::string_view text, std::size_t i)
+{
+	char c = text[i];
+	return !isXmlNameChar(c, i == 0) || (c == '_' && i + 1 < text.size() && text[i + 1] == 'x');
+}
+
+std::size_t xmlNameSize(std::string_view text)
+{
+	if (text.empty())
+		return 1;
+	std::size_t size = text.size();
+	for (std::size_t i = 0; i < text.size(); ++i)
+		if (needsNameEscape(text, i))
+			size += std::strlen("_x0000_") - 1;
+	return size;
+}
+
+char *writeXmlName(char *out, std::string_view text) // returns the end of what was written
+{
+	static const char hex[] = "0123456789ABCDEF";
+	if (text.empty())
+	{
+		*out++ = '_';
+		return out;
+	}
+	for (std::size_t i = 0; i < text.size(); ++i)
+	{
+		if (!needsNameEscape(text, i))
+		{
+			*out++ = text[i];
+			continue;
+		}
+		unsigned char c = static_cast<unsigned char>(text[i]);
+		std::memcpy(out, "_x00", 4);
+		out[4] = hex[c >> 4];
+		out[5] = hex[c & 0xF];
+		out[6] = '_';
+		out += 7;
+	}
+	return out;
+}
+
+char *writeRaw(char *out, std::string_view text)
+{
+	std::memcpy(out, text.data(), text.size());
+	return out + text.size();
+}
 
 // Adaptee: defines the existing interface that needs to be adapted.
 class LegacyAPI
 {
 public:
-	void sendDataXML(const std::string &data)
+	virtual ~LegacyAPI() = default;
+
+	virtual void sendDataXML(const std::string &data)
 	{
 		std::cout << "Sending XML data: " << data << std::endl;
 	}
@@ -32,6 +175,12 @@ class API
 {
 public:
 	virtual void sendData(const std::unordered_map<std::string, std::string> &data) = 0;
+
+	// Lets an implementation that keeps the record take it over instead of copying it.
+	virtual void sendData(std::unordered_map<std::string, std::string> &&data)
+	{
+		sendData(static_cast<const std::unordered_map<std::string, std::string> &>(data));
+	}
 };
 
 // Adapter: adapts the interface of Adaptee to the Target interface.
@@ -41,26 +190,350 @@ public:
 	JsonToXmlAdapter(LegacyAPI &api)
 		: legacyAPI_(api) {}
 
+	using API::sendData;
+
 	void sendData(const std::unordered_map<std::string, std::string> &data) override
 	{
-		std::string xmlData = convertToJsonToXml(data);
-		legacyAPI_.sendDataXML(xmlData);
+		convertToJsonToXml(data, xmlData_);
+		legacyAPI_.sendDataXML(xmlData_);
+	}
+
+	// Writes the XML for `data` into `xmlData`, replacing its contents. The exact size is computed first and
+	// written in place, so once the buffer has grown to the largest message a call allocates nothing.
+	static void convertToJsonToXml(const std::unordered_map<std::string, std::string> &data, std::string &xmlData)
+	{
+		xmlData.clear();
+		appendJsonAsXml(data, xmlData);
+	}
+
+	// Same as convertToJsonToXml, but appends the <data> element after what `xmlData` already holds.
+	static void appendJsonAsXml(const std::unordered_map<std::string, std::string> &data, std::string &xmlData)
+	{
+		std::size_t size = std::strlen("<data></data>");
+		for (auto &[key, value] : data)
+		{
+			size += 2 * xmlNameSize(key) + std::strlen("<></>") + xmlEscapedSize(value);
+		}
+		std::size_t start = xmlData.size();
+		xmlData.resize(start + size);
+		char *out = writeRaw(xmlData.data() + start, "<data>");
+		for (auto &[key, value] : data)
+		{
+			*out++ = '<';
+			char *name = out;
+			out = writeXmlName(out, key);
+			std::size_t nameLength = out - name;
+			*out++ = '>';
+			out = writeXmlEscaped(out, value);
+			out = writeRaw(out, "</");
+			std::memmove(out, name, nameLength);
+			out += nameLength;
+			*out++ = '>';
+		}
+		writeRaw(out, "</data>");
 	}
 
 private:
 	LegacyAPI &legacyAPI_;
+	std::string xmlData_; // reused for every message sent through this adapter
+};
+
+// Batching adapter: gathers many records into one <batch> document per LegacyAPI call, so a slow legacy
+// endpoint costs one round trip per batch instead of one per record. sendData() only queues the record (moved
+// in when passed an rvalue); a pipeline thread converts queued records and delivers a batch once it holds
+// maxRecords records or maxBytes of XML, or once its oldest record has waited maxDelay. The queue is bounded,
+// so a producer that outruns the endpoint is slowed down instead of growing memory without limit.
+// If sendDataXML() throws, that batch is dropped and the exception is rethrown to the caller by the next
+// sendData() or flush(); the destructor discards one that nobody collected.
+class BatchingJsonToXmlAdapter : public API
+{
+public:
+	BatchingJsonToXmlAdapter(LegacyAPI &api, std::size_t maxRecords = 256, std::size_t maxBytes = 64 * 1024,
+							 std::chrono::milliseconds maxDelay = std::chrono::milliseconds(10))
+		: legacyAPI_(api), maxRecords_(maxRecords), maxBytes_(maxBytes), maxDelay_(maxDelay),
+		  pipeline_(&BatchingJsonToXmlAdapter::run, this) {}
 
-	std::string convertToJsonToXml(const std::unordered_map<std::string, std::string> &data)
+	~BatchingJsonToXmlAdapter()
 	{
-		// Implementation of conversion from JSON to XML.
-		std::string xmlData = "<data>";
-		for (auto &[key, value] : data)
 		{
-			xmlData += "<" + key + ">" + value + "</" + key + ">";
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		changed_.notify_all();
+		pipeline_.join(); // delivers whatever is still queued
+	}
+
+	void sendData(const std::unordered_map<std::string, std::string> &data) override
+	{
+		enqueue(std::unordered_map<std::string, std::string>(data));
+	}
+
+	void sendData(std::unordered_map<std::string, std::string> &&data) override
+	{
+		enqueue(std::move(data));
+	}
+
+	// Blocks until every record queued so far has been delivered; throws what a failed delivery threw.
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		std::size_t target = queued_;
+		flushRequested_ = true;
+		changed_.notify_all();
+		changed_.wait(lock, [&] { return delivered_ >= target; });
+		rethrowFailure();
+	}
+
+	std::size_t batchesSent() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return batches_;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void enqueue(std::unordered_map<std::string, std::string> &&data)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		rethrowFailure();
+		changed_.wait(lock, [this] { return queue_.size() < 4 * maxRecords_; });
+		queue_.push_back(std::move(data));
+		++queued_;
+		lock.unlock();
+		changed_.notify_all();
+	}
+
+	void rethrowFailure() // called with the lock held; hands a pipeline failure to the caller once
+	{
+		if (failure_)
+			std::rethrow_exception(std::exchange(failure_, nullptr));
+	}
+
+	void run()
+	{
+		std::deque<std::unordered_map<std::string, std::string>> taken;
+		std::string batch;
+		std::size_t records = 0;
+		Clock::time_point oldest;
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;)
+		{
+			auto ready = [&] { return !queue_.empty() || stopping_ || flushRequested_; };
+			if (records == 0)
+				changed_.wait(lock, ready);
+			else
+				changed_.wait_until(lock, oldest + maxDelay_, ready);
+			taken.swap(queue_); // take everything queued so far in one go
+			bool flushing = stopping_ || flushRequested_;
+			flushRequested_ = false;
+			lock.unlock();
+			changed_.notify_all(); // room in the queue again
+
+			for (auto &data : taken)
+			{
+				if (records == 0)
+				{
+					batch = "<batch>";
+					oldest = Clock::now();
+				}
+				JsonToXmlAdapter::appendJsonAsXml(data, batch);
+				if (++records == maxRecords_ || batch.size() >= maxBytes_)
+				{
+					deliver(batch, records);
+				}
+			}
+			taken.clear();
+			if (records != 0 && (flushing || Clock::now() >= oldest + maxDelay_))
+			{
+				deliver(batch, records);
+			}
+
+			lock.lock();
+			if (stopping_ && queue_.empty() && records == 0)
+				return;
+		}
+	}
+
+	void deliver(std::string &batch, std::size_t &records) // called without the lock held
+	{
+		batch += "</batch>";
+		std::exception_ptr failure;
+		try
+		{
+			legacyAPI_.sendDataXML(batch);
+		}
+		catch (...)
+		{
+			failure = std::current_exception();
 		}
-		xmlData += "</data>";
-		return xmlData;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			delivered_ += records; // handed over, failed or not, so flush() does not wait for them forever
+			if (failure && !failure_)
+				failure_ = failure; // the first failure wins until a caller collects it
+			else if (!failure)
+				++batches_;
+		}
+		changed_.notify_all();
+		records = 0;
 	}
+
+	LegacyAPI &legacyAPI_;
+	const std::size_t maxRecords_;
+	const std::size_t maxBytes_;
+	const std::chrono::milliseconds maxDelay_;
+	mutable std::mutex mutex_;
+	std::condition_variable changed_;
+	std::deque<std::unordered_map<std::string, std::string>> queue_;
+	std::size_t queued_ = 0;    // records accepted by sendData()
+	std::size_t delivered_ = 0; // records handed to the LegacyAPI
+	std::size_t batches_ = 0;       // batches the LegacyAPI accepted
+	std::exception_ptr failure_;    // thrown by sendDataXML(), not yet rethrown to a caller
+	bool flushRequested_ = false;
+	bool stopping_ = false;
+	std::thread pipeline_; // last: starts once everything above is initialized
+};
+
+// Typed adapter: instead of flattening every record into an unordered_map<string, string>, a plain struct
+// lists its fields once at compile time and the adapter writes XML or JSON straight from the typed members.
+// No hash table, no per-field strings; numbers are formatted with to_chars into the output buffer.
+//
+//   struct Order { int id; std::string item; };
+//   template <> struct Fields<Order> {
+//       static constexpr auto list = std::make_tuple(field("id", &Order::id), field("item", &Order::item));
+//   };
+template <typename Record, typename Member>
+struct Field
+{
+	const char *name;
+	Member Record::*member;
+};
+
+template <typename Record, typename Member>
+constexpr Field<Record, Member> field(const char *name, Member Record::*member)
+{
+	return {name, member};
+}
+
+template <typename Record>
+struct Fields; // specialized for every record type sent through StructToXmlAdapter
+
+void appendJsonEscaped(std::string &out, std::string_view text)
+{
+	static const char hex[] = "0123456789abcdef";
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			out += "\\u00";
+			out += hex[c >> 4];
+			out += hex[c & 0xF];
+		}
+		else
+		{
+			out += c;
+		}
+	}
+}
+
+template <typename Value>
+void appendNumber(std::string &out, Value value)
+{
+	char digits[32];
+	auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+template <typename Record>
+class StructToXmlAdapter
+{
+public:
+	StructToXmlAdapter(LegacyAPI &api)
+		: legacyAPI_(api) {}
+
+	void sendData(const Record &record)
+	{
+		toXml(record, xmlData_);
+		legacyAPI_.sendDataXML(xmlData_);
+	}
+
+	// <data><id>7</id><item>tea</item></data>, fields in declaration order. Replaces the contents of `out`.
+	static void toXml(const Record &record, std::string &out)
+	{
+		out.assign("<data>");
+		std::apply([&](const auto &...fields) { (appendXmlField(out, fields.name, record.*fields.member), ...); }, Fields<Record>::list);
+		out += "</data>";
+	}
+
+	// {"id":7,"item":"tea"}. Replaces the contents of `out`.
+	static void toJson(const Record &record, std::string &out)
+	{
+		out.assign("{");
+		std::apply([&](const auto &...fields) { (appendJsonField(out, fields.name, record.*fields.member), ...); }, Fields<Record>::list);
+		if (out.back() == ',')
+			out.back() = '}';
+		else
+			out += '}';
+	}
+
+private:
+	template <typename Value>
+	static void appendXmlField(std::string &out, const char *name, const Value &value)
+	{
+		out += '<';
+		out += name;
+		out += '>';
+		if constexpr (std::is_same_v<Value, bool>)
+		{
+			out += value ? "true" : "false";
+		}
+		else if constexpr (std::is_arithmetic_v<Value>)
+		{
+			appendNumber(out, value);
+		}
+		else
+		{
+			std::string_view text(value);
+			std::size_t start = out.size();
+			out.resize(start + xmlEscapedSize(text));
+			writeXmlEscaped(out.data() + start, text);
+		}
+		out += "</";
+		out += name;
+		out += '>';
+	}
+
+	template <typename Value>
+	static void appendJsonField(std::string &out, const char *name, const Value &value)
+	{
+		out += '"';
+		out += name;
+		out += "\":";
+		if constexpr (std::is_same_v<Value, bool>)
+		{
+			out += value ? "true" : "false";
+		}
+		else if constexpr (std::is_arithmetic_v<Value>)
+		{
+			appendNumber(out, value);
+		}
+		else
+		{
+			out += '"';
+			appendJsonEscaped(out, value);
+			out += '"';
+		}
+		out += ',';
+	}
+
+	LegacyAPI &legacyAPI_;
+	std::string xmlData_; // reused for every message sent through this adapter
 };
 
 // Client code that uses Target interface.
@@ -69,6 +542,99 @@ void sendData(API &api, const std::unordered_map<std::string, std::string> &data
 	api.sendData(data);
 }
 
+void sendData(API &api, std::unordered_map<std::string, std::string> &&data)
+{
+	api.sendData(std::move(data));
+}
+
+////////////////////////// Benchmark //////////////////////////
+// Counts heap allocations so main() can compare the map-based adapter with the typed one.
+std::atomic<std::size_t> allocations{0};
+
+void *operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+struct Order
+{
+	int id;
+	std::string item;
+	int quantity;
+	double price;
+	bool paid;
+};
+
+template <>
+struct Fields<Order>
+{
+	static constexpr auto list = std::make_tuple(field("id", &Order::id), field("item", &Order::item), field("quantity", &Order::quantity),
+												 field("price", &Order::price), field("paid", &Order::paid));
+};
+
+// What callers of API::sendData have to do today: flatten the record into strings first.
+std::unordered_map<std::string, std::string> toMap(const Order &order)
+{
+	return {{"id", std::to_string(order.id)}, {"item", order.item}, {"quantity", std::to_string(order.quantity)},
+			{"price", std::to_string(order.price)}, {"paid", order.paid ? "true" : "false"}};
+}
+
+void compareOrderPaths()
+{
+	const int count = 200000;
+	Order order{0, "flat white", 2, 4.5, true};
+	std::string xml; // reused by both paths, as the adapters do
+	auto measure = [&](const char *name, auto convert) {
+		std::size_t before = allocations.load();
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < count; ++i)
+		{
+			order.id = i;
+			convert();
+		}
+		double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+		std::cout << name << ": " << nanoseconds << " ns, " << double(allocations.load() - before) / count << " allocations per record" << std::endl;
+	};
+	measure("unordered_map path", [&] { JsonToXmlAdapter::convertToJsonToXml(toMap(order), xml); });
+	measure("typed XML path", [&] { StructToXmlAdapter<Order>::toXml(order, xml); });
+	measure("typed JSON path", [&] { StructToXmlAdapter<Order>::toJson(order, xml); });
+}
+//////////////////////////////////////////////
+
+// Stand-in for a remote legacy endpoint: every call costs a fixed round trip.
+class SlowLegacyAPI : public LegacyAPI
+{
+public:
+	explicit SlowLegacyAPI(std::chrono::microseconds latency)
+		: latency_(latency) {}
+
+	void sendDataXML(const std::string &data) override
+	{
+		std::this_thread::sleep_for(latency_);
+		++calls;
+		bytes += data.size();
+	}
+
+	std::size_t calls = 0;
+	std::size_t bytes = 0;
+
+private:
+	std::chrono::microseconds latency_;
+};
+
 int main()
 {
 	// Create a LegacyAPI.
@@ -81,8 +647,77 @@ int main()
 	std::unordered_map<std::string, std::string> jsonData = {{"name", "John"}, {"age", "42"}};
 	sendData(adapter, jsonData);
 
+	// Markup characters in the data are escaped.
+	std::unordered_map<std::string, std::string> noteData = {{"note", "Tom & \"Jerry\" <3"}};
+	sendData(adapter, noteData);
+
+	// Keys that are not valid XML names are mangled into element names that are.
+	std::unordered_map<std::string, std::string> profileData = {{"first name", "Ada"}};
+	sendData(adapter, profileData);
+	sendData(adapter, {{"2fa", "on"}});
+
+	// Same records through a 1 ms round-trip endpoint, one call per record and then batched.
+	const int records = 2000;
+	for (int batched = 0; batched < 2; ++batched)
+	{
+		SlowLegacyAPI remote(std::chrono::milliseconds(1));
+		auto start = std::chrono::steady_clock::now();
+		{
+			JsonToXmlAdapter direct(remote);
+			BatchingJsonToXmlAdapter batching(remote);
+			API &target = batched ? static_cast<API &>(batching) : static_cast<API &>(direct);
+			for (int i = 0; i < records; ++i)
+			{
+				sendData(target, {{"id", std::to_string(i)}, {"item", "coffee"}, {"quantity", "2"}}); // moved into the queue
+			}
+			batching.flush();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << (batched ? "Batched: " : "One call per record: ") << records / seconds << " records/s in "
+				  << remote.calls << " calls" << std::endl;
+	}
+
+	// A failing endpoint reaches the caller instead of terminating the pipeline thread.
+	struct UnavailableLegacyAPI : LegacyAPI
+	{
+		void sendDataXML(const std::string &) override
+		{
+			throw std::runtime_error("endpoint unavailable");
+		}
+	} unavailable;
+	BatchingJsonToXmlAdapter failing(unavailable);
+	sendData(failing, {{"id", "1"}});
+	try
+	{
+		failing.flush();
+	}
+	catch (const std::exception &error)
+	{
+		std::cout << "Batch failed: " << error.what() << std::endl;
+	}
+
+	// Typed records skip the map entirely.
+	LegacyAPI console;
+	StructToXmlAdapter<Order> orders(console);
+	orders.sendData({7, "tea & cake", 1, 3.25, false});
+	std::string json;
+	StructToXmlAdapter<Order>::toJson({7, "tea & cake", 1, 3.25, false}, json);
+	std::cout << json << std::endl;
+	compareOrderPaths();
+
 	/////////// output /////////
 	/// Sending XML data: <data><age>42</age><name>John</name></data>
+	/// Sending XML data: <data><note>Tom &amp; &quot;Jerry&quot; &lt;3</note></data>
+	/// Sending XML data: <data><first_x0020_name>Ada</first_x0020_name></data>
+	/// Sending XML data: <data><_x0032_fa>on</_x0032_fa></data>
+	/// One call per record: 917.113 records/s in 2000 calls
+	/// Batched: 200369 records/s in 8 calls
+	/// Batch failed: endpoint unavailable
+	/// Sending XML data: <data><id>7</id><item>tea &amp; cake</item><quantity>1</quantity><price>3.25</price><paid>false</paid></data>
+	/// {"id":7,"item":"tea & cake","quantity":1,"price":3.25,"paid":false}
+	/// unordered_map path: 1261.05 ns, 6.00001 allocations per record
+	/// typed XML path: 395.739 ns, 0 allocations per record
+	/// typed JSON path: 350.418 ns, 0 allocations per record
 	////////////////////////////
 	return 0;
 }
@@ -48,6 +48,9 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
 
 class Component {
 public:
@@ -82,10 +85,111 @@ public:
 		}
 	}
 
+	const std::vector<Component*>& children() const {
+		return components;
+	}
+
 private:
 	std::vector<Component*> components;
 };
 
+// The same tree kept in one contiguous pool instead of one heap object per node. Nodes are stored as a
+// struct of arrays in DFS pre-order and linked by 32-bit indices (parent, first child, next sibling), so a
+// node's whole subtree is the index range [node, subtreeEnd[node]) and traversing it is a linear scan.
+// node(i) hands out any subtree through the ordinary Component interface.
+class FlatComposite : public Component {
+public:
+	static constexpr std::uint32_t none = UINT32_MAX;
+
+	class Node : public Component {
+	public:
+		Node(const FlatComposite& tree, std::uint32_t index) : tree(tree), index(index) {}
+
+		void operation() override {
+			tree.operation(index);
+		}
+
+	private:
+		const FlatComposite& tree;
+		std::uint32_t index;
+	};
+
+	// Copies the pointer-based tree rooted at `root` in DFS order. Throws length_error past 2^32 - 1 nodes, where
+	// indices would run into `none`.
+	explicit FlatComposite(Component& root) {
+		std::vector<std::uint32_t> lastChild;
+		std::vector<std::pair<Component*, std::uint32_t>> stack{{&root, none}}; // (node, parent index)
+		while (!stack.empty()) {
+			auto [component, parentIndex] = stack.back();
+			stack.pop_back();
+			if (isComposite.size() >= none) {
+				throw std::length_error("FlatComposite: too many nodes for 32-bit indices");
+			}
+			auto index = static_cast<std::uint32_t>(isComposite.size());
+			auto composite = dynamic_cast<Composite*>(component);
+			isComposite.push_back(composite != nullptr);
+			parent.push_back(parentIndex);
+			firstChild.push_back(none);
+			nextSibling.push_back(none);
+			lastChild.push_back(none);
+			if (parentIndex != none) {
+				(lastChild[parentIndex] == none ? firstChild[parentIndex] : nextSibling[lastChild[parentIndex]]) = index;
+				lastChild[parentIndex] = index;
+			}
+			if (composite) {
+				const auto& children = composite->children();
+				for (auto it = children.rbegin(); it != children.rend(); ++it) { // reversed: popped in order
+					stack.push_back({*it, index});
+				}
+			}
+		}
+		subtreeEnd.resize(isComposite.size());
+		for (std::uint32_t i = static_cast<std::uint32_t>(subtreeEnd.size()); i-- > 0;) { // children before parents
+			subtreeEnd[i] = std::max(subtreeEnd[i], i + 1);
+			if (parent[i] != none) {
+				subtreeEnd[parent[i]] = std::max(subtreeEnd[parent[i]], subtreeEnd[i]);
+			}
+		}
+	}
+
+	void operation() override {
+		operation(0);
+	}
+
+	Node node(std::uint32_t index) const {
+		return Node(*this, index);
+	}
+
+	std::uint32_t size() const {
+		return static_cast<std::uint32_t>(parent.size());
+	}
+
+	std::uint32_t parentOf(std::uint32_t index) const {
+		return parent[index];
+	}
+
+	std::uint32_t firstChildOf(std::uint32_t index) const {
+		return firstChild[index];
+	}
+
+	std::uint32_t nextSiblingOf(std::uint32_t index) const {
+		return nextSibling[index];
+	}
+
+private:
+	void operation(std::uint32_t index) const {
+		for (std::uint32_t i = index; i < subtreeEnd[index]; ++i) {
+			std::cout << (isComposite[i] ? "Composite operation" : "Leaf operation") << std::endl;
+		}
+	}
+
+	std::vector<bool> isComposite;
+	std::vector<std::uint32_t> parent;
+	std::vector<std::uint32_t> firstChild;
+	std::vector<std::uint32_t> nextSibling;
+	std::vector<std::uint32_t> subtreeEnd; // one past the last node of the subtree
+};
+
 int main() {
 	Leaf leaf1;
 	Leaf leaf2;
@@ -101,12 +205,25 @@ int main() {
 
 	composite2.operation();
 
+	// Same traversal over the contiguous copy, for the whole tree and for composite1's subtree.
+	FlatComposite flat(composite2);
+	flat.operation();
+	flat.node(flat.firstChildOf(0)).operation();
+
 	///////////// output ////////////
 	// Composite operation
 	// Composite operation
 	// Leaf operation
 	// Leaf operation
 	// Leaf operation
+	// Composite operation
+	// Composite operation
+	// Leaf operation
+	// Leaf operation
+	// Leaf operation
+	// Composite operation
+	// Leaf operation
+	// Leaf operation
 	/////////////////////////////////
 
 	return 0;
@@ -31,8 +31,24 @@
 
 
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <charconv>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <filesystem>
 
 class FurniturePiece {
 public:
@@ -75,11 +91,608 @@ public:
 		return total;
 	}
 
+	const std::vector<FurniturePiece*>& getPieces() const {
+		return pieces;
+	}
+
 private:
 	std::vector<FurniturePiece*> pieces;
 };
 
-int main() {
+// A furniture tree copied into one contiguous pool: a struct of arrays in DFS pre-order, linked by 32-bit
+// parent / first-child / next-sibling indices. Every node's subtree is the index range [node, subtreeEnd),
+// and a composite's price is simply the sum of the leaf prices in that range, so pricing is a linear scan
+// over one array of doubles. A piece used several times (three chairs) is copied once per use, exactly as
+// the recursive calculatePrice() counts it. That includes shared sub-assemblies: on a DAG where each level
+// reuses the one below several times, the copy grows exponentially with depth, so such catalogs belong in
+// FurnitureCatalog instead. piece(i) prices any subtree through the FurniturePiece interface.
+// The constructor throws length_error past 2^32 - 1 nodes, where indices would run into `none`.
+class FlatFurniture : public FurniturePiece {
+public:
+	static constexpr std::uint32_t none = UINT32_MAX;
+
+	class Piece : public FurniturePiece {
+	public:
+		Piece(const FlatFurniture& furniture, std::uint32_t index) : furniture(furniture), index(index) {}
+
+		double calculatePrice() override {
+			return furniture.calculatePrice(index);
+		}
+
+	private:
+		const FlatFurniture& furniture;
+		std::uint32_t index;
+	};
+
+	explicit FlatFurniture(FurniturePiece& root) {
+		std::vector<std::uint32_t> lastChild;
+		std::vector<std::pair<FurniturePiece*, std::uint32_t>> stack{{&root, none}}; // (piece, parent index)
+		while (!stack.empty()) {
+			auto [piece, parentIndex] = stack.back();
+			stack.pop_back();
+			if (leafPrice.size() >= none) {
+				throw std::length_error("FlatFurniture: too many nodes for 32-bit indices");
+			}
+			auto index = static_cast<std::uint32_t>(leafPrice.size());
+			auto composite = dynamic_cast<CompositePiece*>(piece);
+			leafPrice.push_back(composite ? 0.0 : piece->calculatePrice());
+			parent.push_back(parentIndex);
+			firstChild.push_back(none);
+			nextSibling.push_back(none);
+			lastChild.push_back(none);
+			if (parentIndex != none) {
+				(lastChild[parentIndex] == none ? firstChild[parentIndex] : nextSibling[lastChild[parentIndex]]) = index;
+				lastChild[parentIndex] = index;
+			}
+			if (composite) {
+				const auto& pieces = composite->getPieces();
+				for (auto it = pieces.rbegin(); it != pieces.rend(); ++it) { // reversed: popped in order
+					stack.push_back({*it, index});
+				}
+			}
+		}
+		subtreeEnd.resize(leafPrice.size());
+		for (std::uint32_t i = static_cast<std::uint32_t>(subtreeEnd.size()); i-- > 0;) { // children before parents
+			subtreeEnd[i] = std::max(subtreeEnd[i], i + 1);
+			if (parent[i] != none) {
+				subtreeEnd[parent[i]] = std::max(subtreeEnd[parent[i]], subtreeEnd[i]);
+			}
+		}
+	}
+
+	double calculatePrice() override {
+		return calculatePrice(0);
+	}
+
+	Piece piece(std::uint32_t index) const {
+		return Piece(*this, index);
+	}
+
+	std::uint32_t size() const {
+		return static_cast<std::uint32_t>(parent.size());
+	}
+
+	std::uint32_t parentOf(std::uint32_t index) const {
+		return parent[index];
+	}
+
+	std::uint32_t firstChildOf(std::uint32_t index) const {
+		return firstChild[index];
+	}
+
+	std::uint32_t nextSiblingOf(std::uint32_t index) const {
+		return nextSibling[index];
+	}
+
+private:
+	double calculatePrice(std::uint32_t index) const {
+		double total = 0.0;
+		for (std::uint32_t i = index; i < subtreeEnd[index]; ++i) {
+			total += leafPrice[i];
+		}
+		return total;
+	}
+
+	std::vector<double> leafPrice; // 0 for composites
+	std::vector<std::uint32_t> parent;
+	std::vector<std::uint32_t> firstChild;
+	std::vector<std::uint32_t> nextSibling;
+	std::vector<std::uint32_t> subtreeEnd; // one past the last node of the subtree
+};
+
+class CatalogError : public std::runtime_error {
+public:
+	CatalogError(const std::string& what, std::size_t line)
+		: std::runtime_error(line ? what + " on line " + std::to_string(line) : what), line_(line) {}
+	std::size_t line() const { return line_; }
+private:
+	std::size_t line_; // 0 when the error is about the catalog as a whole
+};
+
+// Prices a whole furniture catalog as a DAG. CompositePiece::calculatePrice() re-walks a shared sub-assembly
+// every time it is referenced; here every distinct piece is priced exactly once, children before parents.
+//
+// Catalog files hold one definition per line, in any order ('#' starts a comment):
+//     piece chair 50
+//     assembly diningSet table chair*3
+// Parts are stored compressed (CSR) in both directions, and build() sorts the pieces into levels: a piece's
+// level is one more than its deepest part, so each level depends only on the ones before it and is priced in
+// parallel. After build(), setPrice() on a piece reprices only the assemblies that contain it, directly or not,
+// in level order. Pricing is not synchronized with setPrice(); readers and writers must not overlap.
+// Adding pieces after build() leaves the catalog unbuilt: the pricing calls throw logic_error until build()
+// runs again.
+class FurnitureCatalog {
+public:
+	using Id = std::uint32_t;
+
+	// Shares the catalog's price table rather than pointing at the catalog, so it stays valid when the catalog
+	// is moved or destroyed, and follows setPrice() for as long as the catalog lives.
+	class Piece : public FurniturePiece {
+	public:
+		Piece(std::shared_ptr<const std::vector<double>> prices, Id id) : prices(std::move(prices)), id(id) {}
+
+		double calculatePrice() override {
+			return (*prices)[id];
+		}
+
+	private:
+		std::shared_ptr<const std::vector<double>> prices;
+		Id id;
+	};
+
+	FurnitureCatalog() = default;
+	FurnitureCatalog(FurnitureCatalog&&) = default;
+	FurnitureCatalog& operator=(FurnitureCatalog&&) = default;
+	FurnitureCatalog(const FurnitureCatalog&) = delete; // copies would share one price table
+	FurnitureCatalog& operator=(const FurnitureCatalog&) = delete;
+
+	static FurnitureCatalog load(const std::string& path, unsigned threads = 0) {
+		std::ifstream in(path);
+		if (!in) {
+			throw CatalogError("cannot open " + path, 0);
+		}
+		FurnitureCatalog catalog;
+		std::string line;
+		for (std::size_t number = 1; std::getline(in, line); ++number) {
+			catalog.parseLine(line, number);
+		}
+		catalog.build(threads);
+		return catalog;
+	}
+
+	Id addPiece(const std::string& name, double price) {
+		Id id = define(name, Kind::Piece, 0);
+		basePrice[id] = price;
+		return id;
+	}
+
+	Id addAssembly(const std::string& name, const std::vector<std::pair<std::string, std::uint32_t>>& parts) {
+		Id id = define(name, Kind::Assembly, 0);
+		for (const auto& [part, count] : parts) {
+			edges.push_back({id, idOf(part), count});
+		}
+		return id;
+	}
+
+	// Copies a FurniturePiece graph; a piece reached through several parents is added once, and a part
+	// repeated inside one assembly becomes a single part with a count. Imported pieces have no name.
+	Id import(FurniturePiece& root) {
+		std::unordered_map<FurniturePiece*, Id> seen;
+		std::vector<FurniturePiece*> stack{&root};
+		while (!stack.empty()) {
+			FurniturePiece* piece = stack.back();
+			stack.pop_back();
+			if (seen.count(piece)) {
+				continue;
+			}
+			Id id = newId("");
+			seen[piece] = id;
+			auto composite = dynamic_cast<CompositePiece*>(piece);
+			kind[id] = composite ? Kind::Assembly : Kind::Piece;
+			if (!composite) {
+				basePrice[id] = piece->calculatePrice();
+				continue;
+			}
+			for (FurniturePiece* part : composite->getPieces()) {
+				stack.push_back(part);
+			}
+			importQueue.push_back({id, composite});
+		}
+		for (auto [id, composite] : importQueue) {
+			std::unordered_map<Id, std::uint32_t> counts;
+			std::vector<Id> order;
+			for (FurniturePiece* part : composite->getPieces()) {
+				if (counts[seen[part]]++ == 0) {
+					order.push_back(seen[part]);
+				}
+			}
+			for (Id part : order) {
+				edges.push_back({id, part, counts[part]});
+			}
+		}
+		importQueue.clear();
+		return seen[&root];
+	}
+
+	// Resolves every reference, orders the pieces by level and prices all of them.
+	void build(unsigned threads = 0) {
+		const Id n = static_cast<Id>(names.size());
+		for (Id id = 0; id < n; ++id) {
+			if (kind[id] == Kind::Undefined) {
+				throw CatalogError("'" + names[id] + "' is used but never defined", 0);
+			}
+		}
+		partBegin.assign(n + 1, 0);
+		parentBegin.assign(n + 1, 0);
+		for (const Edge& edge : edges) {
+			++partBegin[edge.assembly + 1];
+			++parentBegin[edge.part + 1];
+		}
+		for (Id id = 0; id < n; ++id) {
+			partBegin[id + 1] += partBegin[id];
+			parentBegin[id + 1] += parentBegin[id];
+		}
+		partId.resize(edges.size());
+		partCount.resize(edges.size());
+		parentId.resize(edges.size());
+		std::vector<std::uint32_t> nextPart(partBegin.begin(), partBegin.end() - 1);
+		std::vector<std::uint32_t> nextParent(parentBegin.begin(), parentBegin.end() - 1);
+		for (const Edge& edge : edges) {
+			partId[nextPart[edge.assembly]] = edge.part;
+			partCount[nextPart[edge.assembly]++] = edge.count;
+			parentId[nextParent[edge.part]++] = edge.assembly;
+		}
+
+		// Kahn's algorithm one wave at a time: each wave is one level.
+		std::vector<std::uint32_t> missing(n);
+		order.clear();
+		levelBegin.assign(1, 0);
+		for (Id id = 0; id < n; ++id) {
+			missing[id] = partBegin[id + 1] - partBegin[id];
+			if (missing[id] == 0) {
+				order.push_back(id);
+			}
+		}
+		for (std::size_t waveBegin = 0; waveBegin < order.size();) {
+			std::size_t waveEnd = order.size();
+			levelBegin.push_back(static_cast<std::uint32_t>(waveEnd));
+			for (std::size_t i = waveBegin; i < waveEnd; ++i) {
+				for (std::uint32_t e = parentBegin[order[i]]; e < parentBegin[order[i] + 1]; ++e) {
+					if (--missing[parentId[e]] == 0) {
+						order.push_back(parentId[e]);
+					}
+				}
+			}
+			waveBegin = waveEnd;
+		}
+		if (order.size() != n) {
+			throw CatalogError("assemblies contain each other (cycle)", 0);
+		}
+		rank.resize(n);
+		for (std::uint32_t i = 0; i < n; ++i) {
+			rank[order[i]] = i;
+		}
+		visited.assign(n, 0);
+		epoch = 0;
+		built = true;
+		priceAll(threads);
+	}
+
+	// Reprices everything from the piece prices, level by level; each level is split across threads.
+	void priceAll(unsigned threads = 0) {
+		requireBuilt();
+		if (!threads) {
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		price->resize(names.size());
+		for (std::size_t level = 0; level + 1 < levelBegin.size(); ++level) {
+			parallelFor(levelBegin[level], levelBegin[level + 1], threads, [this](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; ++i) {
+					reprice(order[i]);
+				}
+			});
+		}
+	}
+
+	// Changes a piece price and reprices only the assemblies above it; returns how many were repriced.
+	std::size_t setPrice(Id id, double newPrice) {
+		requireBuilt();
+		if (kind[id] != Kind::Piece) {
+			throw std::invalid_argument("only pieces have a price of their own");
+		}
+		basePrice[id] = newPrice;
+		(*price)[id] = newPrice;
+		if (++epoch == 0) { // wrapped: old marks could look current
+			std::fill(visited.begin(), visited.end(), 0);
+			epoch = 1;
+		}
+		affected.clear();
+		affected.push_back(id);
+		visited[id] = epoch;
+		for (std::size_t i = 0; i < affected.size(); ++i) {
+			for (std::uint32_t e = parentBegin[affected[i]]; e < parentBegin[affected[i] + 1]; ++e) {
+				if (visited[parentId[e]] != epoch) {
+					visited[parentId[e]] = epoch;
+					affected.push_back(parentId[e]);
+				}
+			}
+		}
+		std::sort(affected.begin() + 1, affected.end(), [this](Id a, Id b) { return rank[a] < rank[b]; });
+		for (std::size_t i = 1; i < affected.size(); ++i) {
+			reprice(affected[i]);
+		}
+		return affected.size() - 1;
+	}
+
+	double priceOf(Id id) const {
+		requireBuilt();
+		return (*price)[id];
+	}
+
+	Piece piece(Id id) const {
+		requireBuilt();
+		return Piece(price, id);
+	}
+
+	Id find(const std::string& name) const {
+		auto it = index.find(name);
+		if (it == index.end()) {
+			throw std::out_of_range("no piece named '" + name + "'");
+		}
+		return it->second;
+	}
+
+	std::size_t size() const {
+		return names.size();
+	}
+
+	std::size_t levels() const {
+		return levelBegin.size() - 1;
+	}
+
+private:
+	enum class Kind : std::uint8_t { Undefined, Piece, Assembly };
+
+	struct Edge {
+		Id assembly;
+		Id part;
+		std::uint32_t count;
+	};
+
+	void requireBuilt() const {
+		if (!built) {
+			throw std::logic_error("FurnitureCatalog: call build() after adding pieces");
+		}
+	}
+
+	Id newId(const std::string& name) { // every new piece, including forward references, invalidates build()
+		built = false;
+		auto id = static_cast<Id>(names.size());
+		names.push_back(name);
+		kind.push_back(Kind::Undefined);
+		basePrice.push_back(0.0);
+		return id;
+	}
+
+	Id idOf(const std::string& name) { // forward references get an id now and a definition later
+		auto [it, inserted] = index.try_emplace(name, 0);
+		if (inserted) {
+			it->second = newId(name);
+		}
+		return it->second;
+	}
+
+	Id define(const std::string& name, Kind as, std::size_t line) {
+		Id id = idOf(name);
+		if (kind[id] != Kind::Undefined) {
+			throw CatalogError("'" + name + "' is defined twice", line);
+		}
+		kind[id] = as;
+		return id;
+	}
+
+	void parseLine(std::string_view line, std::size_t number) {
+		line = line.substr(0, line.find('#'));
+		words.clear();
+		for (std::size_t i = 0; i < line.size();) {
+			std::size_t start = line.find_first_not_of(" \t\r", i);
+			if (start == std::string_view::npos) {
+				break;
+			}
+			std::size_t end = std::min(line.find_first_of(" \t\r", start), line.size());
+			words.push_back(line.substr(start, end - start));
+			i = end;
+		}
+		if (words.empty()) {
+			return;
+		}
+		if (words[0] == "piece" && words.size() == 3) {
+			std::string text(words[2]);
+			char* end = nullptr;
+			double value = std::strtod(text.c_str(), &end);
+			if (end != text.c_str() + text.size()) {
+				throw CatalogError("invalid price '" + text + "'", number);
+			}
+			basePrice[define(std::string(words[1]), Kind::Piece, number)] = value;
+		} else if (words[0] == "assembly" && words.size() >= 3) {
+			Id id = define(std::string(words[1]), Kind::Assembly, number);
+			for (std::size_t i = 2; i < words.size(); ++i) {
+				std::string_view part = words[i];
+				std::uint32_t count = 1;
+				std::size_t star = part.find('*');
+				if (star != std::string_view::npos) {
+					auto result = std::from_chars(part.data() + star + 1, part.data() + part.size(), count);
+					if (result.ec != std::errc() || result.ptr != part.data() + part.size() || count == 0) {
+						throw CatalogError("invalid count in '" + std::string(part) + "'", number);
+					}
+					part = part.substr(0, star);
+				}
+				edges.push_back({id, idOf(std::string(part)), count});
+			}
+		} else {
+			throw CatalogError("expected 'piece <name> <price>' or 'assembly <name> <part>[*count]...'", number);
+		}
+	}
+
+	void reprice(Id id) {
+		if (kind[id] == Kind::Piece) {
+			(*price)[id] = basePrice[id];
+			return;
+		}
+		std::vector<double>& prices = *price;
+		double total = 0.0;
+		for (std::uint32_t e = partBegin[id]; e < partBegin[id + 1]; ++e) {
+			total += partCount[e] * prices[partId[e]];
+		}
+		prices[id] = total;
+	}
+
+	template <typename Fn>
+	static void parallelFor(std::uint32_t begin, std::uint32_t end, unsigned threads, Fn fn) {
+		const std::uint32_t minimumPerThread = 16384; // below this, starting a thread costs more than it saves
+		unsigned workers = static_cast<unsigned>(std::min<std::uint32_t>(threads, (end - begin) / minimumPerThread));
+		if (workers <= 1) {
+			fn(begin, end);
+			return;
+		}
+		std::vector<std::thread> pool;
+		std::uint32_t chunk = (end - begin + workers - 1) / workers;
+		for (unsigned w = 1; w < workers; ++w) {
+			std::uint32_t first = begin + w * chunk;
+			pool.emplace_back(fn, first, std::min(end, first + chunk));
+		}
+		fn(begin, std::min(end, begin + chunk));
+		for (auto& worker : pool) {
+			worker.join();
+		}
+	}
+
+	std::vector<std::string> names;
+	std::unordered_map<std::string, Id> index;
+	std::vector<Kind> kind;
+	std::vector<double> basePrice;                             // pieces only
+	std::vector<Edge> edges;                                   // kept so build() can run again after more definitions
+	std::vector<std::pair<Id, CompositePiece*>> importQueue;   // during import()
+	std::vector<std::uint32_t> partBegin, partId, partCount;   // parts of each assembly (CSR)
+	std::vector<std::uint32_t> parentBegin, parentId;          // assemblies using each piece (CSR)
+	std::vector<Id> order;                                     // by level, so parts always come first
+	std::vector<std::uint32_t> levelBegin;                     // level l is order[levelBegin[l], levelBegin[l + 1])
+	std::vector<std::uint32_t> rank;                           // position in order
+	std::shared_ptr<std::vector<double>> price = std::make_shared<std::vector<double>>(); // shared with Piece handles
+	bool built = false;                                        // build() has run since the last new piece
+	std::vector<std::uint32_t> visited;                        // setPrice() marks, compared against epoch
+	std::uint32_t epoch = 0;
+	std::vector<Id> affected;
+	std::vector<std::string_view> words;                       // parseLine() scratch, reused for every line
+};
+
+////////////////////////// Benchmark //////////////////////////
+// ./composite_002 --bench [products] [threads] : a synthetic catalog where hardware is shared by sub-assemblies,
+// sub-assemblies by modules and modules by products. Writes it to a file, loads it, and compares the level
+// pricing with CompositePiece::calculatePrice() on the same graph, then times an incremental price change.
+void benchmarkCatalog(std::uint32_t products, unsigned threads) {
+	const std::uint32_t hardware = 2000, subAssemblies = 20000, modules = 100000;
+	std::mt19937 random(42);
+	auto pick = [&](std::uint32_t n) { return static_cast<std::uint32_t>(random() % n); };
+	std::vector<IndividualPiece*> hardwarePieces;
+	std::vector<CompositePiece*> assemblies; // sub-assemblies, then modules, then products
+	std::string path = (std::filesystem::temp_directory_path() / "furniture_catalog.txt").string();
+	{
+		std::ofstream out(path);
+		for (std::uint32_t i = 0; i < hardware; ++i) {
+			double price = 1 + pick(5000) / 100.0;
+			hardwarePieces.push_back(new IndividualPiece(price));
+			out << "piece h" << i << ' ' << price << '\n';
+		}
+		auto addAssembly = [&](const std::string& name, std::uint32_t parts, auto choose) {
+			CompositePiece* assembly = new CompositePiece();
+			out << "assembly " << name;
+			for (std::uint32_t p = 0; p < parts; ++p) {
+				auto [label, piece] = choose();
+				std::uint32_t count = 1 + pick(3);
+				out << ' ' << label << '*' << count;
+				for (std::uint32_t c = 0; c < count; ++c) {
+					assembly->addPiece(piece);
+				}
+			}
+			out << '\n';
+			assemblies.push_back(assembly);
+		};
+		for (std::uint32_t i = 0; i < subAssemblies; ++i) {
+			addAssembly("s" + std::to_string(i), 4 + pick(5), [&] {
+				std::uint32_t h = pick(hardware);
+				return std::pair<std::string, FurniturePiece*>("h" + std::to_string(h), hardwarePieces[h]);
+			});
+		}
+		for (std::uint32_t i = 0; i < modules; ++i) {
+			addAssembly("m" + std::to_string(i), 2 + pick(3), [&] {
+				std::uint32_t s = pick(subAssemblies);
+				return std::pair<std::string, FurniturePiece*>("s" + std::to_string(s), assemblies[s]);
+			});
+		}
+		for (std::uint32_t i = 0; i < products; ++i) {
+			addAssembly("p" + std::to_string(i), 2 + pick(4), [&] {
+				std::uint32_t m = pick(modules);
+				return std::pair<std::string, FurniturePiece*>("m" + std::to_string(m), assemblies[subAssemblies + m]);
+			});
+		}
+	}
+	auto since = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	double recursiveTotal = 0.0;
+	for (std::uint32_t i = 0; i < products; ++i) {
+		recursiveTotal += assemblies[subAssemblies + modules + i]->calculatePrice();
+	}
+	double recursiveMs = since(start);
+
+	start = std::chrono::steady_clock::now();
+	FurnitureCatalog catalog = FurnitureCatalog::load(path, threads);
+	double loadMs = since(start);
+	std::vector<FurnitureCatalog::Id> productIds;
+	for (std::uint32_t i = 0; i < products; ++i) {
+		productIds.push_back(catalog.find("p" + std::to_string(i)));
+	}
+	start = std::chrono::steady_clock::now();
+	catalog.priceAll(1);
+	double serialMs = since(start);
+	start = std::chrono::steady_clock::now();
+	catalog.priceAll(threads);
+	double parallelMs = since(start);
+	double catalogTotal = 0.0;
+	for (auto id : productIds) {
+		catalogTotal += catalog.priceOf(id);
+	}
+
+	start = std::chrono::steady_clock::now();
+	std::size_t repriced = catalog.setPrice(catalog.find("h0"), 99.0);
+	double updateMs = since(start);
+
+	std::cout << "Pieces: " << catalog.size() << " in " << catalog.levels() << " levels, loaded in " << loadMs << " ms" << std::endl;
+	std::cout << "Recursive calculatePrice: " << recursiveMs << " ms, level pricing: " << serialMs << " ms on 1 thread, "
+			  << parallelMs << " ms on " << threads << (std::abs(recursiveTotal - catalogTotal) <= 1e-9 * recursiveTotal ? "" : " (mismatch!)")
+			  << std::endl;
+	std::cout << "Price change on h0: " << repriced << " assemblies repriced in " << updateMs << " ms" << std::endl;
+
+	std::remove(path.c_str());
+	for (auto piece : hardwarePieces) {
+		delete piece;
+	}
+	for (auto assembly : assemblies) {
+		delete assembly;
+	}
+}
+//////////////////////////////////////////////
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string(argv[1]) == "--bench") {
+		benchmarkCatalog(argc > 2 ? std::stoul(argv[2]) : 1000000,
+						 argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency()));
+		return 0;
+	}
+
 	// Create individual pieces
 	FurniturePiece* chair = new IndividualPiece(50.0);
 	FurniturePiece* table = new IndividualPiece(100.0);
@@ -105,9 +718,53 @@ int main() {
 	std::cout << "Dining set price: $" << diningSetPrice << std::endl;
 	std::cout << "Living room set price: $" << livingRoomSetPrice << std::endl;
 
+	// The same prices from a contiguous copy of a house made of both sets.
+	CompositePiece* house = new CompositePiece();
+	house->addPiece(diningSet);
+	house->addPiece(livingRoomSet);
+	FlatFurniture flatHouse(*house);
+	std::cout << "House price: $" << flatHouse.calculatePrice() << ", living room set: $"
+			  << flatHouse.piece(flatHouse.nextSiblingOf(flatHouse.firstChildOf(0))).calculatePrice() << std::endl;
+
+	// A catalog prices every shared sub-assembly once and reprices only what a change reaches.
+	std::string catalogPath = (std::filesystem::temp_directory_path() / "furniture_demo.txt").string();
+	std::ofstream(catalogPath) << "# pieces can be listed in any order\n"
+								  "assembly house diningSet livingRoomSet\n"
+								  "assembly diningSet table chair*3\n"
+								  "assembly livingRoomSet sofa chair*2 table\n"
+								  "piece chair 50\npiece table 100\npiece sofa 200\n";
+	FurnitureCatalog catalog = FurnitureCatalog::load(catalogPath);
+	std::remove(catalogPath.c_str());
+	std::cout << "Catalog house price: $" << catalog.priceOf(catalog.find("house")) << std::endl;
+	std::size_t repriced = catalog.setPrice(catalog.find("chair"), 60.0);
+	std::cout << "Chairs at $60: dining set $" << catalog.piece(catalog.find("diningSet")).calculatePrice() << ", house $"
+			  << catalog.priceOf(catalog.find("house")) << " (" << repriced << " assemblies repriced)" << std::endl;
+	// A Piece handle survives moving the catalog; new pieces need another build() before pricing.
+	FurnitureCatalog::Piece catalogDiningSet = catalog.piece(catalog.find("diningSet"));
+	FurnitureCatalog moved = std::move(catalog);
+	moved.addPiece("lamp", 30.0);
+	try {
+		moved.priceOf(moved.find("house"));
+	} catch (const std::logic_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+	moved.build();
+	std::cout << "After the move and a rebuild: dining set $" << catalogDiningSet.calculatePrice() << std::endl;
+
+	FurnitureCatalog imported;
+	FurnitureCatalog::Id importedHouse = imported.import(*house);
+	imported.build();
+	std::cout << "Imported house price: $" << imported.priceOf(importedHouse) << " from " << imported.size() << " distinct pieces" << std::endl;
+
 	///////// output //////
 	// Dining set price: $250
 	// Living room set price: $400
+	// House price: $650, living room set: $400
+	// Catalog house price: $650
+	// Chairs at $60: dining set $280, house $700 (3 assemblies repriced)
+	// FurnitureCatalog: call build() after adding pieces
+	// After the move and a rebuild: dining set $280
+	// Imported house price: $650 from 6 distinct pieces
 	///////////////////////
 
 	// Clean up
@@ -116,6 +773,7 @@ int main() {
 	delete sofa;
 	delete diningSet;
 	delete livingRoomSet;
+	delete house;
 
 	return 0;
 }
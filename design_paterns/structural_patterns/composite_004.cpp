@@ -2,18 +2,230 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <string_view>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+#include <chrono>
+#include <algorithm>
+#include <optional>
+#include <cmath>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <memory_resource>
+#include <system_error>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Appends `text` with the characters JSON requires to be escaped turned into escape sequences.
+void appendEscaped(std::string& out, std::string_view text) {
+	static const char hex[] = "0123456789abcdef";
+	for (char c : text) {
+		switch (c) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\r': out += "\\r"; break;
+		case '\t': out += "\\t"; break;
+		case '\b': out += "\\b"; break;
+		case '\f': out += "\\f"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				out += "\\u00";
+				out += hex[(c >> 4) & 0xF];
+				out += hex[c & 0xF];
+			} else {
+				out += c;
+			}
+		}
+	}
+}
+
+bool needsEscaping(std::string_view text) {
+	for (char c : text) {
+		if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) return true;
+	}
+	return false;
+}
+
+std::string escaped(std::string_view text) {
+	std::string out;
+	if (!needsEscaping(text)) return std::string(text);
+	appendEscaped(out, text);
+	return out;
+}
+
+// Appends JSON text into one reusable growable buffer, optionally streaming it to a file descriptor once the
+// buffer passes flushThreshold. Compact mode produces exactly what toString() returns; pretty mode indents
+// nested containers by two spaces. A failed write throws std::system_error and keeps the unwritten text
+// buffered; the destructor flushes too but cannot report, so call flush() last to see the error.
+class JsonWriter {
+public:
+	enum class Mode { Compact, Pretty };
+
+	explicit JsonWriter(Mode mode = Mode::Compact, int fd = -1, std::size_t flushThreshold = 64 * 1024)
+		: mode_{mode}, fd_{fd}, flushThreshold_{flushThreshold} {
+		buffer_.reserve(fd_ >= 0 ? flushThreshold_ + 4096 : 4096);
+	}
+
+	~JsonWriter() {
+		try {
+			flush();
+		} catch (const std::system_error&) { // call flush() first to find out about it
+		}
+	}
+
+	void write(char c) {
+		buffer_.push_back(c);
+		if (fd_ >= 0 && buffer_.size() >= flushThreshold_) flush();
+	}
+
+	void write(std::string_view text) {
+		buffer_.append(text.data(), text.size());
+		if (fd_ >= 0 && buffer_.size() >= flushThreshold_) flush();
+	}
+
+	void beginContainer(char open) {
+		write(open);
+		++depth_;
+	}
+
+	void endContainer(char close, bool empty) {
+		--depth_;
+		if (!empty) newline();
+		write(close);
+	}
+
+	void separator(bool first) { // before every element or property
+		if (!first) write(',');
+		newline();
+	}
+
+	void writeEscaped(std::string_view text) { // string contents, with JSON escapes where needed
+		if (!needsEscaping(text)) {
+			write(text);
+			return;
+		}
+		appendEscaped(buffer_, text);
+		if (fd_ >= 0 && buffer_.size() >= flushThreshold_) flush();
+	}
+
+	void key(std::string_view name) {
+		write('"');
+		writeEscaped(name);
+		write(mode_ == Mode::Pretty ? "\": " : "\":");
+	}
+
+	void flush() { // Hand the buffered text to the file descriptor (no-op when writing to memory)
+		if (fd_ < 0) return;
+		std::size_t done = 0;
+		while (done < buffer_.size()) {
+			ssize_t written = ::write(fd_, buffer_.data() + done, buffer_.size() - done);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0) {
+				int error = written < 0 ? errno : EIO; // 0 bytes for a non-empty write: nothing will ever go through
+				buffer_.erase(0, done);                // keep only the tail that did not make it
+				throw std::system_error(error, std::generic_category(), "JsonWriter: write");
+			}
+			done += static_cast<std::size_t>(written);
+		}
+		buffer_.clear(); // keeps the capacity for the next chunk
+	}
+
+	const std::string& str() const { return buffer_; }
+	void clear() { buffer_.clear(); depth_ = 0; } // reuse the same allocation for the next document
+
+private:
+	void newline() {
+		if (mode_ != Mode::Pretty) return;
+		write('\n');
+		for (int i = 0; i < depth_; ++i) write("  ");
+	}
+
+	Mode mode_;
+	int fd_;
+	std::size_t flushThreshold_;
+	std::string buffer_;
+	int depth_ = 0;
+};
+
+enum class JsonType { Null, Bool, Number, String, Array, Object };
+
+// Receives the values of a document in document order. Tree (JsonValue) and tape (JsonTape) documents can
+// both be walked with it, which is also how one is converted into the other.
+class JsonVisitor {
+public:
+	virtual ~JsonVisitor() = default;
+	virtual void visitNull() = 0;
+	virtual void visitBool(bool value) = 0;
+	virtual void visitNumber(double value) = 0;
+	virtual void visitString(std::string_view value) = 0;
+	virtual void beginObject(std::size_t size) = 0;
+	virtual void visitKey(std::string_view key) = 0; // before each property value
+	virtual void endObject() = 0;
+	virtual void beginArray(std::size_t size) = 0;
+	virtual void endArray() = 0;
+};
 
 class JsonValue {
 public:
 	virtual ~JsonValue() = default;
 	virtual std::string toString() const = 0;
+	virtual void serialize(JsonWriter& writer) const = 0; // no temporaries: everything is appended to the writer
+	virtual void accept(JsonVisitor& visitor) const = 0;
 };
 
+// Writes the shortest text that parses back to exactly `value` and returns its length. std::to_chars
+// implements Ryu, is locale-independent and never allocates; integral values within 2^53 take the integer
+// path so ids and counters print as all their digits ("1000000000000000", not "1e+15"). JSON has no NaN or
+// infinity, so those become null.
+std::size_t formatNumber(double value, char (&buffer)[32]) {
+	if (!std::isfinite(value)) {
+		std::memcpy(buffer, "null", 4);
+		return 4;
+	}
+	if (value == 0.0) { // keeps the sign of -0.0
+		return std::signbit(value) ? (std::memcpy(buffer, "-0", 2), 2) : (buffer[0] = '0', 1);
+	}
+	if (std::fabs(value) < 9007199254740992.0 && value == std::trunc(value)) {
+		return static_cast<std::size_t>(std::to_chars(buffer, buffer + sizeof(buffer), static_cast<std::int64_t>(value)).ptr - buffer);
+	}
+	return static_cast<std::size_t>(std::to_chars(buffer, buffer + sizeof(buffer), value).ptr - buffer);
+}
+
 class JsonNumber : public JsonValue {
 public:
 	JsonNumber(double value) : value_{value} {}
 	std::string toString() const override {
-		return std::to_string(value_);
+		char buffer[32];
+		return std::string(buffer, formatNumber(value_, buffer));
+	}
+	void serialize(JsonWriter& writer) const override {
+		char buffer[32];
+		writer.write(std::string_view(buffer, formatNumber(value_, buffer)));
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.visitNumber(value_);
 	}
 private:
 	double value_;
@@ -21,19 +233,116 @@ private:
 
 class JsonString : public JsonValue {
 public:
-	JsonString(std::string value) : value_{value} {}
+	JsonString(std::string value) : value_{std::move(value)} {}
 	std::string toString() const override {
-		return "\"" + value_ + "\"";
+		return "\"" + escaped(value_) + "\"";
+	}
+	void serialize(JsonWriter& writer) const override {
+		writer.write('"');
+		writer.writeEscaped(value_);
+		writer.write('"');
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.visitString(value_);
 	}
 private:
 	std::string value_;
 };
 
+class JsonNull : public JsonValue {
+public:
+	std::string toString() const override {
+		return "null";
+	}
+	void serialize(JsonWriter& writer) const override {
+		writer.write("null");
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.visitNull();
+	}
+};
+
+// Process-wide pool of object keys. Every distinct key is stored once and objects keep string_views into it,
+// so a million records sharing one schema share one copy of each key. Pooled keys live until the program
+// exits, so the pool is capped: past maxKeys distinct keys, and for keys longer than maxKeyLength (ids and
+// other data used as keys rather than schema), intern() returns nothing and the object owns its key instead.
+class JsonKeyPool {
+public:
+	static constexpr std::size_t maxKeys = 1 << 16;
+	static constexpr std::size_t maxKeyLength = 128;
+
+	static std::optional<std::string_view> intern(std::string_view key) {
+		if (key.size() > maxKeyLength) return std::nullopt;
+		std::size_t hash = std::hash<std::string_view>{}(key);
+		CachedKey& cached = threadCache()[hash % cacheSize]; // lock-free hit for the keys a thread keeps seeing
+		if (cached.key.data() != nullptr && cached.hash == hash && cached.key == key) return cached.key;
+		std::optional<std::string_view> pooled = instance().insert(key);
+		if (pooled) cached = {hash, *pooled};
+		return pooled;
+	}
+	static std::size_t size() {
+		JsonKeyPool& pool = instance();
+		std::lock_guard<std::mutex> lock(pool.mutex_);
+		return pool.keys_.size();
+	}
+
+private:
+	struct CachedKey {
+		std::size_t hash = 0;
+		std::string_view key;
+	};
+	struct KeyHash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+	};
+	static constexpr std::size_t cacheSize = 256;
+
+	static JsonKeyPool& instance() {
+		static JsonKeyPool pool;
+		return pool;
+	}
+	static CachedKey* threadCache() {
+		thread_local CachedKey cache[cacheSize];
+		return cache;
+	}
+	std::optional<std::string_view> insert(std::string_view key) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = keys_.find(key);
+		if (it == keys_.end()) {
+			if (keys_.size() >= maxKeys) return std::nullopt; // full: the caller keeps its own copy
+			it = keys_.emplace(key).first; // node-based: the string never moves once inserted
+		}
+		return std::string_view(*it);
+	}
+
+	std::mutex mutex_;
+	std::unordered_set<std::string, KeyHash, std::equal_to<>> keys_;
+};
+
 class JsonObject : public JsonValue {
 public:
-	void add(std::string key, std::shared_ptr<JsonValue> value) {
-		properties_.push_back(std::make_pair(key, value));
+	// Small objects are scanned linearly; past indexThreshold properties a hash index is built once and then
+	// kept up to date by add(). Duplicate keys keep their place in properties_, lookups return the first one.
+	static constexpr std::size_t indexThreshold = 16;
+
+	void add(std::string_view key, std::shared_ptr<JsonValue> value) {
+		append(storeKey(key), std::move(value));
 	}
+	std::shared_ptr<JsonValue> find(std::string_view key) const { // nullptr when the key is missing
+		std::size_t position = indexOf(key);
+		return position == npos ? nullptr : properties_[position].second;
+	}
+	bool contains(std::string_view key) const { return indexOf(key) != npos; }
+	std::shared_ptr<JsonValue>& operator[](std::string_view key) { // inserts null when the key is missing
+		std::size_t position = indexOf(key);
+		if (position == npos) {
+			add(key, std::make_shared<JsonNull>());
+			position = properties_.size() - 1;
+		}
+		return properties_[position].second;
+	}
+	std::size_t size() const { return properties_.size(); }
+
 	std::string toString() const override {
 		std::string result = "{";
 		bool first = true;
@@ -41,21 +350,76 @@ public:
 			if (!first) {
 				result += ",";
 			}
-			result += "\"" + property.first + "\":" + property.second->toString();
+			result += "\"" + escaped(property.first) + "\":" + property.second->toString();
 			first = false;
 		}
 		result += "}";
 		return result;
 	}
+	void serialize(JsonWriter& writer) const override {
+		writer.beginContainer('{');
+		bool first = true;
+		for (const auto& property : properties_) {
+			writer.separator(first);
+			writer.key(property.first);
+			property.second->serialize(writer);
+			first = false;
+		}
+		writer.endContainer('}', properties_.empty());
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.beginObject(properties_.size());
+		for (const auto& property : properties_) {
+			visitor.visitKey(property.first);
+			property.second->accept(visitor);
+		}
+		visitor.endObject();
+	}
 private:
-	std::vector<std::pair<std::string, std::shared_ptr<JsonValue>>> properties_;
+	friend class JsonParser; // stores each decoded key once, before parsing the value overwrites it
+
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	std::string_view storeKey(std::string_view key) { // pooled when possible, otherwise owned by this object
+		if (std::optional<std::string_view> pooled = JsonKeyPool::intern(key)) return *pooled;
+		if (!ownedKeys_) ownedKeys_ = std::make_unique<std::deque<std::string>>();
+		return ownedKeys_->emplace_back(key); // deque: earlier keys stay where they are
+	}
+	void append(std::string_view storedKey, std::shared_ptr<JsonValue> value) {
+		properties_.emplace_back(storedKey, std::move(value));
+		if (index_) index_->emplace(properties_.back().first, properties_.size() - 1);
+		else if (properties_.size() > indexThreshold) buildIndex();
+	}
+
+	std::size_t indexOf(std::string_view key) const {
+		if (index_) {
+			auto it = index_->find(key);
+			return it == index_->end() ? npos : it->second;
+		}
+		for (std::size_t i = 0; i < properties_.size(); ++i) {
+			std::string_view candidate = properties_[i].first;
+			if (candidate.size() == key.size() && (candidate.data() == key.data() || candidate == key)) return i;
+		}
+		return npos;
+	}
+	void buildIndex() {
+		index_ = std::make_unique<std::unordered_map<std::string_view, std::size_t>>();
+		index_->reserve(properties_.size() * 2);
+		for (std::size_t i = 0; i < properties_.size(); ++i) index_->emplace(properties_[i].first, i);
+	}
+
+	std::vector<std::pair<std::string_view, std::shared_ptr<JsonValue>>> properties_; // keys point into JsonKeyPool or ownedKeys_
+	std::unique_ptr<std::unordered_map<std::string_view, std::size_t>> index_;
+	std::unique_ptr<std::deque<std::string>> ownedKeys_; // keys the pool declined; allocated on first use
 };
 
 class JsonArray : public JsonValue {
 public:
 	void add(std::shared_ptr<JsonValue> value) {
-		elements_.push_back(value);
+		elements_.push_back(std::move(value));
 	}
+	std::shared_ptr<JsonValue> at(std::size_t position) const { return elements_.at(position); }
+	std::size_t size() const { return elements_.size(); }
 	std::string toString() const override {
 		std::string result = "[";
 		bool first = true;
@@ -69,28 +433,1786 @@ public:
 		result += "]";
 		return result;
 	}
+	void serialize(JsonWriter& writer) const override {
+		writer.beginContainer('[');
+		bool first = true;
+		for (const auto& element : elements_) {
+			writer.separator(first);
+			element->serialize(writer);
+			first = false;
+		}
+		writer.endContainer(']', elements_.empty());
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.beginArray(elements_.size());
+		for (const auto& element : elements_) {
+			element->accept(visitor);
+		}
+		visitor.endArray();
+	}
 private:
 	std::vector<std::shared_ptr<JsonValue>> elements_;
 };
 
-class JsonNull : public JsonValue {
+class JsonBool : public JsonValue {
 public:
+	JsonBool(bool value) : value_{value} {}
 	std::string toString() const override {
-		return "null";
+		return value_ ? "true" : "false";
 	}
+	void serialize(JsonWriter& writer) const override {
+		writer.write(value_ ? "true" : "false");
+	}
+	void accept(JsonVisitor& visitor) const override {
+		visitor.visitBool(value_);
+	}
+private:
+	bool value_;
 };
 
-int main() {
-	auto jsonNumber = std::make_shared<JsonNumber>(3.14);
-	auto jsonString = std::make_shared<JsonString>("hello");
-	auto jsonArray = std::make_shared<JsonArray>();
-	jsonArray->add(std::make_shared<JsonString>("world"));
-	jsonArray->add(std::make_shared<JsonNumber>(42));
-	auto jsonObject = std::make_shared<JsonObject>();
-	jsonObject->add("number", jsonNumber);
-	jsonObject->add("string", jsonString);
-	jsonObject->add("array", jsonArray);
-	jsonObject->add("null", std::make_shared<JsonNull>());
-	std::cout << jsonObject->toString() << std::endl;
+class JsonParseError : public std::runtime_error {
+public:
+	JsonParseError(const std::string& what, std::size_t offset)
+		: std::runtime_error(what + " at offset " + std::to_string(offset)), offset_{offset} {}
+	std::size_t offset() const { return offset_; }
+private:
+	std::size_t offset_;
+};
+
+// Stage 1 of the parsers below, plus the token decoding they share. Like simdjson, parsing runs in two stages:
+//  1. indexStructurals() classifies the input 64 bytes at a time with SIMD compares (AVX2 or SSE2, picked at
+//     runtime, with a scalar fallback) and records the offset of every structural character ({}[]:,), every
+//     string start and every scalar start that is not inside a string.
+//  2. A builder walks that index recursively, so it never has to look at whitespace or string contents twice.
+// Strings are unescaped and validated as UTF-8; errors throw JsonParseError with the byte offset.
+// Only stage 1 reaches the 1 GB/s target: 1.2-2.3 GB/s on the --bench corpora. A full parse is bound by stage 2
+// and stays an order of magnitude below it (see JsonParser and JsonTape).
+class JsonScanner {
+public:
+	static std::vector<std::uint32_t> indexStructurals(std::string_view text) {
+		if (text.size() > std::numeric_limits<std::uint32_t>::max()) { // offsets are stored as 32 bits
+			throw JsonParseError("document larger than 4 GiB", std::numeric_limits<std::uint32_t>::max());
+		}
+		std::vector<std::uint32_t> indices;
+		indices.reserve(text.size() / 8 + 16);
+		BlockState state;
+		const ClassifyFn classify = classifier();
+		std::size_t offset = 0;
+		for (; offset + 64 <= text.size(); offset += 64) {
+			indexBlock(classify(text.data() + offset), offset, state, indices);
+		}
+		if (offset < text.size()) { // last partial block, padded with spaces
+			char block[64];
+			std::memset(block, ' ', sizeof(block));
+			std::memcpy(block, text.data() + offset, text.size() - offset);
+			indexBlock(classify(block), offset, state, indices);
+		}
+		if (state.inString) throw JsonParseError("unterminated string", text.size());
+		return indices;
+	}
+
+protected:
+	static constexpr int maxDepth = 1024;
+
+	explicit JsonScanner(std::string_view text) : text_{text}, indices_{indexStructurals(text)} {
+		if (indices_.empty()) throw JsonParseError("empty document", 0);
+	}
+
+	struct Unindexed {}; // skips stage 1, for readers that only decode the tokens they are asked for
+	JsonScanner(std::string_view text, Unindexed) : text_{text} {}
+
+	void checkDepth(int depth) const {
+		if (next_ >= indices_.size()) throw JsonParseError("unexpected end of input", text_.size());
+		if (depth > maxDepth) throw JsonParseError("document nested too deeply", indices_[next_]);
+	}
+
+	void expectEnd() const { // nothing but whitespace may follow the root value
+		if (next_ != indices_.size()) throw JsonParseError("trailing content", indices_[next_]);
+	}
+
+	std::size_t expectKey() { // position of the key's opening quote; consumes the ':'
+		if (next_ >= indices_.size() || charAt(next_) != '"') throw JsonParseError("expected a string key", next_ < indices_.size() ? indices_[next_] : text_.size());
+		std::size_t key = indices_[next_++];
+		if (next_ >= indices_.size() || charAt(next_) != ':') throw JsonParseError("expected ':'", next_ < indices_.size() ? indices_[next_] : text_.size());
+		++next_;
+		return key;
+	}
+
+	bool closeOrComma(std::size_t containerPosition, char close) { // true once the container is closed
+		if (next_ >= indices_.size()) throw JsonParseError(close == '}' ? "unterminated object" : "unterminated array", containerPosition);
+		char c = charAt(next_++);
+		if (c == close) return true;
+		if (c != ',') throw JsonParseError(close == '}' ? "expected ',' or '}'" : "expected ',' or ']'", indices_[next_ - 1]);
+		return false;
+	}
+
+	bool emptyContainer(char close) {
+		if (next_ < indices_.size() && charAt(next_) == close) {
+			++next_;
+			return true;
+		}
+		return false;
+	}
+
+	struct BlockMasks { // bit i describes byte i of a 64-byte block
+		std::uint64_t quote;
+		std::uint64_t backslash;
+		std::uint64_t op; // { } [ ] : ,
+		std::uint64_t whitespace;
+	};
+
+	struct BlockState { // carried from one block to the next
+		bool escapeNext = false;   // block ended in an unescaped backslash
+		bool inString = false;     // block ended inside a string
+		bool afterScalar = false;  // block ended in the middle of a scalar token
+	};
+
+	using ClassifyFn = BlockMasks (*)(const char*);
+
+	static BlockMasks classifyScalar(const char* block) {
+		BlockMasks masks{0, 0, 0, 0};
+		for (int i = 0; i < 64; ++i) {
+			std::uint64_t bit = std::uint64_t{1} << i;
+			switch (block[i]) {
+			case '"': masks.quote |= bit; break;
+			case '\\': masks.backslash |= bit; break;
+			case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+			case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+			default: break;
+			}
+		}
+		return masks;
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	static std::uint64_t equalMask(__m128i a, __m128i b, __m128i c, __m128i d, char value) {
+		__m128i v = _mm_set1_epi8(value);
+		return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, v))))
+			| static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(b, v)))) << 16
+			| static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c, v)))) << 32
+			| static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(d, v)))) << 48;
+	}
+
+	static BlockMasks classifySse2(const char* block) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+		__m128i lower = _mm_set1_epi8(0x20); // '[' | 0x20 == '{' and ']' | 0x20 == '}'
+		__m128i la = _mm_or_si128(a, lower), lb = _mm_or_si128(b, lower), lc = _mm_or_si128(c, lower), ld = _mm_or_si128(d, lower);
+		BlockMasks masks;
+		masks.quote = equalMask(a, b, c, d, '"');
+		masks.backslash = equalMask(a, b, c, d, '\\');
+		masks.op = equalMask(la, lb, lc, ld, '{') | equalMask(la, lb, lc, ld, '}') | equalMask(a, b, c, d, ':') | equalMask(a, b, c, d, ',');
+		masks.whitespace = equalMask(a, b, c, d, ' ') | equalMask(a, b, c, d, '\t') | equalMask(a, b, c, d, '\n') | equalMask(a, b, c, d, '\r');
+		return masks;
+	}
+
+	__attribute__((target("avx2"))) static std::uint64_t equalMask(__m256i low, __m256i high, char value) {
+		__m256i v = _mm256_set1_epi8(value);
+		return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, v))))
+			| static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, v)))) << 32;
+	}
+
+	__attribute__((target("avx2"))) static BlockMasks classifyAvx2(const char* block) {
+		__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		__m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+		__m256i lower = _mm256_set1_epi8(0x20);
+		__m256i foldedLow = _mm256_or_si256(low, lower), foldedHigh = _mm256_or_si256(high, lower);
+		BlockMasks masks;
+		masks.quote = equalMask(low, high, '"');
+		masks.backslash = equalMask(low, high, '\\');
+		masks.op = equalMask(foldedLow, foldedHigh, '{') | equalMask(foldedLow, foldedHigh, '}') | equalMask(low, high, ':') | equalMask(low, high, ',');
+		masks.whitespace = equalMask(low, high, ' ') | equalMask(low, high, '\t') | equalMask(low, high, '\n') | equalMask(low, high, '\r');
+		return masks;
+	}
+
+	static ClassifyFn classifier() {
+		static const ClassifyFn fn = __builtin_cpu_supports("avx2") ? classifyAvx2 : classifySse2;
+		return fn;
+	}
+#else
+	static ClassifyFn classifier() { return classifyScalar; }
+#endif
+
+	static std::uint64_t unescapedQuotes(const BlockMasks& masks, BlockState& state) {
+		// Characters preceded by an odd run of backslashes are escaped. Backslashes are rare, so walk them one by one.
+		std::uint64_t escaped = 0;
+		std::uint64_t backslash = masks.backslash;
+		if (state.escapeNext) {
+			escaped = 1;
+			backslash &= ~std::uint64_t{1}; // an escaped backslash does not escape anything
+			state.escapeNext = false;
+		}
+		while (backslash != 0) {
+			int i = __builtin_ctzll(backslash);
+			if (i == 63) {
+				state.escapeNext = true;
+				break;
+			}
+			escaped |= std::uint64_t{1} << (i + 1);
+			backslash &= ~(std::uint64_t{3} << i);
+		}
+		return masks.quote & ~escaped;
+	}
+
+	static std::uint64_t insideStrings(std::uint64_t quotes, BlockState& state) {
+		// Prefix XOR: bit i is set when an odd number of quotes precede or sit at i, i.e. from an opening quote
+		// (inclusive) up to its closing quote (exclusive).
+		std::uint64_t inString = quotes;
+		for (int shift = 1; shift < 64; shift <<= 1) inString ^= inString << shift;
+		if (state.inString) inString = ~inString;
+		state.inString = (inString >> 63) != 0;
+		return inString;
+	}
+
+	static void indexBlock(const BlockMasks& masks, std::size_t offset, BlockState& state, std::vector<std::uint32_t>& indices) {
+		std::uint64_t quotes = unescapedQuotes(masks, state);
+		std::uint64_t inString = insideStrings(quotes, state);
+		std::uint64_t scalar = ~(masks.op | masks.whitespace | masks.quote | inString);
+		std::uint64_t scalarStarts = scalar & ~((scalar << 1) | (state.afterScalar ? 1 : 0));
+		state.afterScalar = (scalar >> 63) != 0;
+
+		std::uint64_t structurals = (masks.op & ~inString) | (quotes & inString) | scalarStarts;
+		while (structurals != 0) {
+			indices.push_back(static_cast<std::uint32_t>(offset + __builtin_ctzll(structurals)));
+			structurals &= structurals - 1;
+		}
+	}
+
+	char charAt(std::size_t index) const { return text_[indices_[index]]; }
+
+	bool isDelimiter(std::size_t position) const { // what may follow a scalar token
+		if (position >= text_.size()) return true;
+		switch (text_[position]) {
+		case ' ': case '\t': case '\n': case '\r': case ',': case ':': case ']': case '}': case '[': case '{': case '"': return true;
+		default: return false;
+		}
+	}
+
+	void expectLiteral(std::size_t position, std::string_view literal) const {
+		if (text_.substr(position, literal.size()) != literal || !isDelimiter(position + literal.size())) {
+			throw JsonParseError("invalid literal", position);
+		}
+	}
+
+	double parseNumber(std::size_t position) const {
+		// Validate the JSON grammar first: from_chars alone would accept "1.", ".5", "+1", "01", "inf", ...
+		std::size_t i = position;
+		auto digits = [&] { std::size_t start = i; while (i < text_.size() && text_[i] >= '0' && text_[i] <= '9') ++i; return i - start; };
+		if (i < text_.size() && text_[i] == '-') ++i;
+		if (i < text_.size() && text_[i] == '0') ++i;
+		else if (digits() == 0) throw JsonParseError("invalid value", position);
+		if (i < text_.size() && text_[i] == '.') {
+			++i;
+			if (digits() == 0) throw JsonParseError("digit expected after '.'", i);
+		}
+		if (i < text_.size() && (text_[i] == 'e' || text_[i] == 'E')) {
+			++i;
+			if (i < text_.size() && (text_[i] == '+' || text_[i] == '-')) ++i;
+			if (digits() == 0) throw JsonParseError("digit expected in exponent", i);
+		}
+		if (!isDelimiter(i)) throw JsonParseError("invalid number", position);
+		double value = 0.0; // from_chars is correctly rounded, so formatNumber() output reads back to the same bits
+		std::from_chars_result result = std::from_chars(text_.data() + position, text_.data() + i, value);
+		if (result.ec == std::errc::result_out_of_range) throw JsonParseError("number out of range", position);
+		return value;
+	}
+
+	static int hexValue(char c) {
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	unsigned parseHex4(std::size_t position) const {
+		if (position + 4 > text_.size()) throw JsonParseError("truncated \\u escape", position);
+		unsigned value = 0;
+		for (std::size_t i = 0; i < 4; ++i) {
+			int digit = hexValue(text_[position + i]);
+			if (digit < 0) throw JsonParseError("invalid \\u escape", position);
+			value = (value << 4) | static_cast<unsigned>(digit);
+		}
+		return value;
+	}
+
+	static void appendUtf8(std::string& out, unsigned codePoint) {
+		if (codePoint < 0x80) {
+			out += static_cast<char>(codePoint);
+		} else if (codePoint < 0x800) {
+			out += static_cast<char>(0xC0 | (codePoint >> 6));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else if (codePoint < 0x10000) {
+			out += static_cast<char>(0xE0 | (codePoint >> 12));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else {
+			out += static_cast<char>(0xF0 | (codePoint >> 18));
+			out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	std::size_t utf8SequenceLength(std::size_t i) const { // validates one multi-byte sequence starting at i
+		auto byte = [&](std::size_t k) { return k < text_.size() ? static_cast<unsigned char>(text_[k]) : 0u; };
+		auto continuation = [&](std::size_t k) { return (byte(k) & 0xC0) == 0x80; };
+		unsigned lead = byte(i);
+		unsigned second = byte(i + 1);
+		if (lead >= 0xC2 && lead <= 0xDF) {
+			if (continuation(i + 1)) return 2;
+		} else if (lead >= 0xE0 && lead <= 0xEF) {
+			bool secondOk = lead == 0xE0 ? (second >= 0xA0 && second <= 0xBF) // no overlong encodings
+				: lead == 0xED ? (second >= 0x80 && second <= 0x9F)            // no UTF-16 surrogates
+				: continuation(i + 1);
+			if (secondOk && continuation(i + 2)) return 3;
+		} else if (lead >= 0xF0 && lead <= 0xF4) {
+			bool secondOk = lead == 0xF0 ? (second >= 0x90 && second <= 0xBF)
+				: lead == 0xF4 ? (second >= 0x80 && second <= 0x8F) // nothing above U+10FFFF
+				: continuation(i + 1);
+			if (secondOk && continuation(i + 2) && continuation(i + 3)) return 4;
+		}
+		throw JsonParseError("invalid UTF-8", i);
+	}
+
+	std::size_t skipPlain(std::size_t i) const { // first byte at or after i that is '"', '\\', a control character or non-ASCII
+#if defined(__x86_64__) || defined(__i386__)
+		const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), control = _mm_set1_epi8(0x1F);
+		for (; i + 16 <= text_.size(); i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text_.data() + i));
+			__m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+				_mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control)); // bytes <= 0x1F
+			int mask = _mm_movemask_epi8(special) | _mm_movemask_epi8(chunk); // sign bit: non-ASCII
+			if (mask != 0) return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+		}
+#endif
+		while (i < text_.size()) {
+			unsigned char c = static_cast<unsigned char>(text_[i]);
+			if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) break;
+			++i;
+		}
+		return i;
+	}
+
+	std::string parseString(std::size_t position) const { // position of the opening quote
+		std::string out;
+		parseString(position, out);
+		return out;
+	}
+
+	void parseString(std::size_t position, std::string& out) const { // appends the unescaped contents to `out`
+		std::size_t i = position + 1;
+		for (;;) {
+			std::size_t end = skipPlain(i);
+			out.append(text_.data() + i, end - i);
+			i = end;
+			if (i >= text_.size()) throw JsonParseError("unterminated string", position);
+			unsigned char c = static_cast<unsigned char>(text_[i]);
+			if (c == '"') return;
+			if (c < 0x20) throw JsonParseError("control character in string", i);
+			if (c >= 0x80) {
+				std::size_t length = utf8SequenceLength(i);
+				out.append(text_.data() + i, length);
+				i += length;
+				continue;
+			}
+			if (i + 1 >= text_.size()) throw JsonParseError("unterminated string", position);
+			char escape = text_[i + 1];
+			i += 2;
+			switch (escape) {
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				unsigned codePoint = parseHex4(i);
+				i += 4;
+				if (codePoint >= 0xD800 && codePoint <= 0xDBFF) { // high surrogate: a low one must follow
+					if (i + 2 > text_.size() || text_[i] != '\\' || text_[i + 1] != 'u') throw JsonParseError("unpaired surrogate", i);
+					unsigned low = parseHex4(i + 2);
+					if (low < 0xDC00 || low > 0xDFFF) throw JsonParseError("unpaired surrogate", i);
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					i += 6;
+				} else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+					throw JsonParseError("unpaired surrogate", i);
+				}
+				appendUtf8(out, codePoint);
+				break;
+			}
+			default:
+				throw JsonParseError("invalid escape", i - 1);
+			}
+		}
+	}
+
+	std::string_view text_;
+	std::vector<std::uint32_t> indices_; // offsets of structural characters, string starts and scalar starts
+	std::size_t next_ = 0;               // next entry of indices_ to consume
+};
+
+// Allocator whose copies share ownership of a memory resource. allocate_shared keeps a copy in every control
+// block, so a pool handed out through it is released only after its owner and the last node taken from it.
+template <typename T>
+class SharedResourceAllocator {
+public:
+	using value_type = T;
+
+	explicit SharedResourceAllocator(std::shared_ptr<std::pmr::memory_resource> resource) : resource_{std::move(resource)} {}
+	template <typename U>
+	SharedResourceAllocator(const SharedResourceAllocator<U>& other) : resource_{other.resource_} {}
+
+	T* allocate(std::size_t n) { return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T* p, std::size_t n) { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+	bool operator==(const SharedResourceAllocator& other) const { return resource_ == other.resource_; }
+
+private:
+	template <typename> friend class SharedResourceAllocator;
+	std::shared_ptr<std::pmr::memory_resource> resource_;
+};
+
+// Builds the JsonValue composite from text. This path does not meet the 1 GB/s target and is not close to it:
+// 0.07-0.17 GB/s on the --bench corpora, against 1.2-2.3 GB/s for stage 1 on the same input. Every value is a
+// separately allocated, reference-counted, virtual JsonValue node and every object a keyed container, so the
+// builder's cost is allocation and pointer bookkeeping per value rather than scanning; the pool resource only
+// makes the allocations cheaper. Getting near 1 GB/s takes a flat representation: JsonTape (0.20-0.36 GB/s with
+// its scalar stage 2) or JsonLazyDocument, which builds nothing it is not asked for.
+class JsonParser : public JsonScanner {
+public:
+	// Nodes are allocated from `nodes`; a pool resource lets a caller that parses many small documents recycle
+	// node storage from one document to the next. The resource must outlive the returned tree.
+	static std::shared_ptr<JsonValue> parse(std::string_view text, std::pmr::memory_resource* nodes = std::pmr::new_delete_resource()) {
+		JsonParser parser(text, nodes, nullptr);
+		std::shared_ptr<JsonValue> root = parser.parseValue(0);
+		parser.expectEnd();
+		return root;
+	}
+
+	// Same, but every node shares ownership of `nodes`, so the tree may outlive the caller's reference to it.
+	static std::shared_ptr<JsonValue> parse(std::string_view text, std::shared_ptr<std::pmr::memory_resource> nodes) {
+		JsonParser parser(text, nodes.get(), std::move(nodes));
+		std::shared_ptr<JsonValue> root = parser.parseValue(0);
+		parser.expectEnd();
+		return root;
+	}
+
+private:
+	JsonParser(std::string_view text, std::pmr::memory_resource* nodes, std::shared_ptr<std::pmr::memory_resource> owner)
+		: JsonScanner(text), nodes_{nodes}, owner_{std::move(owner)} {}
+
+	template <typename Node, typename... Args>
+	std::shared_ptr<Node> make(Args&&... args) { // node and control block in one allocation from nodes_
+		if (owner_) return std::allocate_shared<Node>(SharedResourceAllocator<Node>(owner_), std::forward<Args>(args)...);
+		return std::allocate_shared<Node>(std::pmr::polymorphic_allocator<Node>(nodes_), std::forward<Args>(args)...);
+	}
+
+	std::shared_ptr<JsonValue> parseValue(int depth) {
+		checkDepth(depth);
+		std::size_t position = indices_[next_++];
+		switch (text_[position]) {
+		case '{': return parseObject(position, depth);
+		case '[': return parseArray(position, depth);
+		case '"': return make<JsonString>(parseString(position));
+		case 't': expectLiteral(position, "true"); return make<JsonBool>(true);
+		case 'f': expectLiteral(position, "false"); return make<JsonBool>(false);
+		case 'n': expectLiteral(position, "null"); return make<JsonNull>();
+		default: return make<JsonNumber>(parseNumber(position));
+		}
+	}
+
+	std::shared_ptr<JsonValue> parseObject(std::size_t position, int depth) {
+		auto object = make<JsonObject>();
+		if (emptyContainer('}')) return object;
+		do {
+			key_.clear(); // decoded into a reused buffer, stored before the value can overwrite it
+			parseString(expectKey(), key_);
+			std::string_view key = object->storeKey(key_);
+			object->append(key, parseValue(depth + 1));
+		} while (!closeOrComma(position, '}'));
+		return object;
+	}
+
+	std::shared_ptr<JsonValue> parseArray(std::size_t position, int depth) {
+		auto array = make<JsonArray>();
+		if (emptyContainer(']')) return array;
+		do {
+			array->add(parseValue(depth + 1));
+		} while (!closeOrComma(position, ']'));
+		return array;
+	}
+
+	std::pmr::memory_resource* nodes_;
+	std::shared_ptr<std::pmr::memory_resource> owner_; // set when the nodes must keep nodes_ alive
+	std::string key_;
+};
+
+// Alternative document model: the whole document lives in one allocation holding a flat tape of tagged
+// 64-bit words followed by a string arena, and is freed in one shot. The top 8 bits of a word are its tag:
+//   '{' / '[' : low 32 bits = index of the matching close word, bits 32..55 = number of properties / elements
+//   '}' / ']' : low 32 bits = index of the opening word
+//   '"'       : byte offset of the string in the arena (stored as u32 length + bytes, not null-terminated)
+//   'd'       : the next word holds the raw bits of the double
+//   't' 'f' 'n'
+// An object is its open word, then key string / value pairs, then its close word (same layout as simdjson).
+class JsonCursor;
+
+class JsonTape {
+public:
+	static JsonTape parse(std::string_view text);
+	static JsonTape fromTree(const JsonValue& root);
+
+	std::shared_ptr<JsonValue> toTree() const;
+	JsonCursor root() const;
+	void accept(JsonVisitor& visitor) const;
+
+	std::size_t tapeLength() const { return tapeLength_; }                   // 64-bit words in use
+	std::size_t bytesAllocated() const { return wordsAllocated_ * sizeof(std::uint64_t); }
+
+private:
+	friend class JsonCursor;
+	friend class JsonTapeBuilder;
+
+	static constexpr std::uint64_t payloadMask = (std::uint64_t{1} << 56) - 1;
+
+	char tag(std::size_t index) const { return static_cast<char>(words_[index] >> 56); }
+	std::uint64_t payload(std::size_t index) const { return words_[index] & payloadMask; }
+	std::size_t matching(std::size_t index) const { return static_cast<std::size_t>(payload(index) & 0xFFFFFFFF); }
+	std::size_t skip(std::size_t index) const { // index of the word following the value at `index`
+		switch (tag(index)) {
+		case '{': case '[': return matching(index) + 1;
+		case 'd': return index + 2;
+		default: return index + 1;
+		}
+	}
+	std::string_view stringAt(std::size_t index) const {
+		const char* at = strings_ + payload(index);
+		std::uint32_t length;
+		std::memcpy(&length, at, sizeof(length));
+		return std::string_view(at + sizeof(length), length);
+	}
+	double numberAt(std::size_t index) const {
+		double value;
+		std::memcpy(&value, &words_[index + 1], sizeof(value));
+		return value;
+	}
+	std::size_t count(std::size_t index) const {
+		std::size_t stored = static_cast<std::size_t>(payload(index) >> 32);
+		if (stored != 0xFFFFFF) return stored;
+		std::size_t n = 0; // saturated: count by walking
+		for (std::size_t i = index + 1; i < matching(index); i = skip(tag(index) == '{' ? i + 1 : i)) ++n;
+		return n;
+	}
+	std::size_t visit(std::size_t index, JsonVisitor& visitor) const;
+
+	std::unique_ptr<std::uint64_t[]> words_; // tape first, string arena after it
+	std::size_t wordsAllocated_ = 0;
+	std::size_t tapeLength_ = 0;
+	char* strings_ = nullptr;
+};
+
+// Read-only view of one value on a JsonTape; cheap to copy, valid as long as the tape lives.
+class JsonCursor {
+public:
+	JsonType type() const {
+		switch (tape_->tag(index_)) {
+		case '{': return JsonType::Object;
+		case '[': return JsonType::Array;
+		case '"': return JsonType::String;
+		case 'd': return JsonType::Number;
+		case 'n': return JsonType::Null;
+		default: return JsonType::Bool;
+		}
+	}
+
+	double number() const { expect(JsonType::Number); return tape_->numberAt(index_); }
+	std::string_view string() const { expect(JsonType::String); return tape_->stringAt(index_); }
+	bool boolean() const { expect(JsonType::Bool); return tape_->tag(index_) == 't'; }
+	bool isNull() const { return type() == JsonType::Null; }
+
+	std::size_t size() const { // properties of an object or elements of an array
+		if (type() != JsonType::Object) expect(JsonType::Array);
+		return tape_->count(index_);
+	}
+
+	template <typename Fn>
+	void forEachElement(Fn fn) const { // fn(JsonCursor element)
+		expect(JsonType::Array);
+		for (std::size_t i = index_ + 1; i < tape_->matching(index_); i = tape_->skip(i)) fn(JsonCursor(tape_, i));
+	}
+
+	template <typename Fn>
+	void forEachProperty(Fn fn) const { // fn(std::string_view key, JsonCursor value)
+		expect(JsonType::Object);
+		for (std::size_t i = index_ + 1; i < tape_->matching(index_); i = tape_->skip(i + 1)) fn(tape_->stringAt(i), JsonCursor(tape_, i + 1));
+	}
+
+	JsonCursor operator[](std::size_t position) const { // array element, O(position)
+		expect(JsonType::Array);
+		std::size_t i = index_ + 1;
+		for (std::size_t n = 0; n < position && i < tape_->matching(index_); ++n) i = tape_->skip(i);
+		if (i >= tape_->matching(index_)) throw std::out_of_range("JsonCursor: index out of range");
+		return JsonCursor(tape_, i);
+	}
+
+	std::optional<JsonCursor> find(std::string_view key) const { // first property named `key`, linear scan
+		expect(JsonType::Object);
+		for (std::size_t i = index_ + 1; i < tape_->matching(index_); i = tape_->skip(i + 1)) {
+			if (tape_->stringAt(i) == key) return JsonCursor(tape_, i + 1);
+		}
+		return std::nullopt;
+	}
+
+	void accept(JsonVisitor& visitor) const { tape_->visit(index_, visitor); }
+
+private:
+	friend class JsonTape;
+	JsonCursor(const JsonTape* tape, std::size_t index) : tape_{tape}, index_{index} {}
+
+	void expect(JsonType wanted) const {
+		if (type() != wanted) throw std::runtime_error("JsonCursor: value has a different type");
+	}
+
+	const JsonTape* tape_;
+	std::size_t index_;
+};
+
+inline JsonCursor JsonTape::root() const {
+	if (!words_ || tapeLength_ == 0) throw std::runtime_error("JsonTape: empty tape"); // default-constructed or moved from
+	return JsonCursor(this, 0);
+}
+
+inline void JsonTape::accept(JsonVisitor& visitor) const {
+	if (!words_ || tapeLength_ == 0) throw std::runtime_error("JsonTape: empty tape");
+	visit(0, visitor);
+}
+
+inline std::size_t JsonTape::visit(std::size_t index, JsonVisitor& visitor) const {
+	switch (tag(index)) {
+	case '{': {
+		visitor.beginObject(count(index));
+		std::size_t i = index + 1;
+		while (i < matching(index)) {
+			visitor.visitKey(stringAt(i));
+			i = visit(i + 1, visitor);
+		}
+		visitor.endObject();
+		return i + 1;
+	}
+	case '[': {
+		visitor.beginArray(count(index));
+		std::size_t i = index + 1;
+		while (i < matching(index)) i = visit(i, visitor);
+		visitor.endArray();
+		return i + 1;
+	}
+	case '"': visitor.visitString(stringAt(index)); return index + 1;
+	case 'd': visitor.visitNumber(numberAt(index)); return index + 2;
+	case 't': visitor.visitBool(true); return index + 1;
+	case 'f': visitor.visitBool(false); return index + 1;
+	default: visitor.visitNull(); return index + 1;
+	}
+}
+
+// Appends words and strings into a JsonTape whose single allocation was sized up front: maxWords must be
+// exact or an upper bound, maxStringBytes an upper bound on the arena.
+class JsonTapeBuilder {
+public:
+	JsonTapeBuilder(std::size_t maxWords, std::size_t maxStringBytes) {
+		tape_.wordsAllocated_ = maxWords + (maxStringBytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+		tape_.words_.reset(new std::uint64_t[tape_.wordsAllocated_ == 0 ? 1 : tape_.wordsAllocated_]);
+		tape_.strings_ = reinterpret_cast<char*>(tape_.words_.get() + maxWords);
+	}
+
+	std::size_t open(char tag) { // returns the index to hand back to close()
+		std::size_t index = append(tag, 0);
+		counts_.push_back(0);
+		return index;
+	}
+
+	void close(std::size_t openIndex, char tag) {
+		std::uint64_t count = std::min<std::uint64_t>(counts_.back(), 0xFFFFFF);
+		counts_.pop_back();
+		std::size_t closeIndex = append(tag, openIndex);
+		tape_.words_[openIndex] |= (count << 32) | closeIndex;
+	}
+
+	void string(std::string_view value) {
+		append('"', stringsLength_);
+		std::uint32_t length = static_cast<std::uint32_t>(value.size());
+		std::memcpy(tape_.strings_ + stringsLength_, &length, sizeof(length));
+		std::memcpy(tape_.strings_ + stringsLength_ + sizeof(length), value.data(), value.size());
+		stringsLength_ += sizeof(length) + value.size();
+	}
+
+	void key(std::string_view name) { // same as string() but does not count as an element
+		string(name);
+		--counts_.back();
+	}
+
+	void number(double value) {
+		append('d', 0);
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		tape_.words_[tape_.tapeLength_++] = bits;
+	}
+
+	void literal(char tag) { append(tag, 0); }
+
+	JsonTape finish() { // no copy: whatever the string estimate overshot stays as a gap at the end of the arena
+		return std::move(tape_);
+	}
+
+private:
+	std::size_t append(char tag, std::uint64_t payload) {
+		if (!counts_.empty() && tag != '}' && tag != ']') ++counts_.back();
+		tape_.words_[tape_.tapeLength_] = (static_cast<std::uint64_t>(static_cast<unsigned char>(tag)) << 56) | payload;
+		return tape_.tapeLength_++;
+	}
+
+	JsonTape tape_;
+	std::size_t stringsLength_ = 0;
+	std::vector<std::uint64_t> counts_; // elements seen so far in each open container
+};
+
+// Parses text straight onto a tape: no node objects, no per-value allocation.
+class JsonTapeParser : public JsonScanner {
+public:
+	static JsonTape parse(std::string_view text) {
+		JsonTapeParser parser(text);
+		std::size_t words = 0, stringBytes = 0;
+		parser.measure(words, stringBytes);
+		JsonTapeBuilder builder(words, stringBytes);
+		parser.parseValue(builder, 0);
+		parser.expectEnd();
+		return builder.finish();
+	}
+
+private:
+	explicit JsonTapeParser(std::string_view text) : JsonScanner(text) {}
+
+	// Exact tape length: every index yields the words of the token it starts (none for ':' and ','). A decoded
+	// string is never longer than the text up to the next index, which bounds the arena tightly.
+	void measure(std::size_t& words, std::size_t& stringBytes) const {
+		for (std::size_t k = 0; k < indices_.size(); ++k) {
+			switch (charAt(k)) {
+			case ':': case ',': break;
+			case '{': case '}': case '[': case ']': case 't': case 'f': case 'n': ++words; break;
+			case '"': {
+				std::size_t end = k + 1 < indices_.size() ? indices_[k + 1] : text_.size();
+				++words;
+				stringBytes += sizeof(std::uint32_t) + (end - indices_[k]);
+				break;
+			}
+			default: words += 2; break; // number: tag word and value word
+			}
+		}
+	}
+
+	void parseValue(JsonTapeBuilder& builder, int depth) {
+		checkDepth(depth);
+		std::size_t position = indices_[next_++];
+		switch (text_[position]) {
+		case '{': {
+			std::size_t open = builder.open('{');
+			if (!emptyContainer('}')) {
+				do {
+					decodeInto(expectKey());
+					builder.key(scratch_);
+					parseValue(builder, depth + 1);
+				} while (!closeOrComma(position, '}'));
+			}
+			builder.close(open, '}');
+			break;
+		}
+		case '[': {
+			std::size_t open = builder.open('[');
+			if (!emptyContainer(']')) {
+				do {
+					parseValue(builder, depth + 1);
+				} while (!closeOrComma(position, ']'));
+			}
+			builder.close(open, ']');
+			break;
+		}
+		case '"': decodeInto(position); builder.string(scratch_); break;
+		case 't': expectLiteral(position, "true"); builder.literal('t'); break;
+		case 'f': expectLiteral(position, "false"); builder.literal('f'); break;
+		case 'n': expectLiteral(position, "null"); builder.literal('n'); break;
+		default: builder.number(parseNumber(position)); break;
+		}
+	}
+
+	void decodeInto(std::size_t position) {
+		scratch_.clear(); // keeps its capacity: one buffer reused for every string
+		parseString(position, scratch_);
+	}
+
+	std::string scratch_;
+};
+
+inline JsonTape JsonTape::parse(std::string_view text) { return JsonTapeParser::parse(text); }
+
+// Sizes a tape for an existing tree (first pass of JsonTape::fromTree).
+class TapeSizeVisitor : public JsonVisitor {
+public:
+	void visitNull() override { ++words; }
+	void visitBool(bool) override { ++words; }
+	void visitNumber(double) override { words += 2; }
+	void visitString(std::string_view value) override { ++words; stringBytes += sizeof(std::uint32_t) + value.size(); }
+	void beginObject(std::size_t) override { ++words; }
+	void visitKey(std::string_view key) override { visitString(key); }
+	void endObject() override { ++words; }
+	void beginArray(std::size_t) override { ++words; }
+	void endArray() override { ++words; }
+
+	std::size_t words = 0;
+	std::size_t stringBytes = 0;
+};
+
+// Replays a tree onto a tape (second pass of JsonTape::fromTree).
+class TapeBuildingVisitor : public JsonVisitor {
+public:
+	explicit TapeBuildingVisitor(JsonTapeBuilder& builder) : builder_{builder} {}
+	void visitNull() override { builder_.literal('n'); }
+	void visitBool(bool value) override { builder_.literal(value ? 't' : 'f'); }
+	void visitNumber(double value) override { builder_.number(value); }
+	void visitString(std::string_view value) override { builder_.string(value); }
+	void beginObject(std::size_t) override { opened_.push_back(builder_.open('{')); }
+	void visitKey(std::string_view key) override { builder_.key(key); }
+	void endObject() override { builder_.close(opened_.back(), '}'); opened_.pop_back(); }
+	void beginArray(std::size_t) override { opened_.push_back(builder_.open('[')); }
+	void endArray() override { builder_.close(opened_.back(), ']'); opened_.pop_back(); }
+private:
+	JsonTapeBuilder& builder_;
+	std::vector<std::size_t> opened_;
+};
+
+// Rebuilds JsonValue nodes from visitor events (used by JsonTape::toTree).
+class TreeBuildingVisitor : public JsonVisitor {
+public:
+	void visitNull() override { place(std::make_shared<JsonNull>()); }
+	void visitBool(bool value) override { place(std::make_shared<JsonBool>(value)); }
+	void visitNumber(double value) override { place(std::make_shared<JsonNumber>(value)); }
+	void visitString(std::string_view value) override { place(std::make_shared<JsonString>(std::string(value))); }
+	void beginObject(std::size_t) override {
+		auto object = std::make_shared<JsonObject>();
+		place(object);
+		open_.push_back({object, nullptr});
+	}
+	void visitKey(std::string_view key) override { key_.assign(key.data(), key.size()); }
+	void endObject() override { open_.pop_back(); }
+	void beginArray(std::size_t) override {
+		auto array = std::make_shared<JsonArray>();
+		place(array);
+		open_.push_back({nullptr, array});
+	}
+	void endArray() override { open_.pop_back(); }
+
+	std::shared_ptr<JsonValue> root;
+
+private:
+	void place(std::shared_ptr<JsonValue> value) {
+		if (open_.empty()) root = std::move(value);
+		else if (open_.back().first) open_.back().first->add(key_, std::move(value));
+		else open_.back().second->add(std::move(value));
+	}
+
+	std::vector<std::pair<std::shared_ptr<JsonObject>, std::shared_ptr<JsonArray>>> open_; // one side is set
+	std::string key_;
+};
+
+inline JsonTape JsonTape::fromTree(const JsonValue& root) {
+	TapeSizeVisitor size;
+	root.accept(size);
+	JsonTapeBuilder builder(size.words, size.stringBytes);
+	TapeBuildingVisitor fill(builder);
+	root.accept(fill);
+	return builder.finish();
+}
+
+inline std::shared_ptr<JsonValue> JsonTape::toTree() const {
+	TreeBuildingVisitor builder;
+	accept(builder);
+	return builder.root;
+}
+
+// On-demand document mode for consumers that read a handful of fields out of a large payload. Nothing is
+// parsed up front: a container lists its children the first time one of them is asked for, and every child
+// it walks past is skipped with a bracket-matching scan (the stage 1 block classifier, minus the index), so
+// untouched subtrees are never decoded or allocated. Only the values actually read are fully validated.
+// The text must outlive the document; the document must outlive its JsonLazyValue handles. Not thread-safe.
+class JsonLazyValue;
+
+class JsonLazyDocument : private JsonScanner {
+public:
+	explicit JsonLazyDocument(std::string_view text) : JsonScanner(text, Unindexed{}), root_{skipWhitespace(0)} {
+		if (root_ >= text_.size()) throw JsonParseError("empty document", 0);
+	}
+	JsonLazyDocument(const JsonLazyDocument&) = delete;
+	JsonLazyDocument& operator=(const JsonLazyDocument&) = delete;
+
+	JsonLazyValue root();
+
+	std::size_t containersIndexed() const { return containers_.size(); }
+
+private:
+	friend class JsonLazyValue;
+
+	struct Child {
+		std::string_view key; // unescaped; empty for array elements
+		std::size_t value;    // offset of the value's first byte
+	};
+
+	struct Container {
+		std::vector<Child> children;
+		std::unique_ptr<std::unordered_map<std::string_view, std::size_t>> byKey; // built like JsonObject's index
+	};
+
+	std::size_t skipWhitespace(std::size_t i) const {
+		while (i < text_.size() && (text_[i] == ' ' || text_[i] == '\n' || text_[i] == '\r' || text_[i] == '\t')) ++i;
+		return i;
+	}
+
+	std::size_t matchingClose(std::size_t position) const { // offset of the bracket closing the one at `position`
+		BlockState state;
+		const ClassifyFn classify = classifier();
+		std::size_t depth = 0;
+		char padded[64];
+		for (std::size_t offset = position; offset < text_.size(); offset += 64) {
+			const char* block = text_.data() + offset;
+			if (offset + 64 > text_.size()) { // last partial block, padded with spaces
+				std::memset(padded, ' ', sizeof(padded));
+				std::memcpy(padded, block, text_.size() - offset);
+				block = padded;
+			}
+			BlockMasks masks = classify(block);
+			std::uint64_t outside = masks.op & ~insideStrings(unescapedQuotes(masks, state), state);
+			for (; outside != 0; outside &= outside - 1) {
+				char c = block[__builtin_ctzll(outside)];
+				if (c == '{' || c == '[') {
+					++depth;
+				} else if ((c == '}' || c == ']') && --depth == 0) {
+					return offset + static_cast<std::size_t>(__builtin_ctzll(outside));
+				}
+			}
+		}
+		throw JsonParseError(text_[position] == '{' ? "unterminated object" : "unterminated array", position);
+	}
+
+	std::size_t closingQuote(std::size_t position) const { // offset of the quote ending the string at `position`
+		std::size_t i = position + 1;
+		for (;;) {
+			i = skipPlain(i);
+			if (i >= text_.size()) throw JsonParseError("unterminated string", position);
+			if (text_[i] == '"') return i;
+			i += text_[i] == '\\' ? 2 : 1;
+		}
+	}
+
+	std::size_t valueEnd(std::size_t position) const { // one past the last byte of the value at `position`
+		switch (text_[position]) {
+		case '{': case '[': return matchingClose(position) + 1;
+		case '"': return closingQuote(position) + 1;
+		default: {
+			std::size_t i = position;
+			while (!isDelimiter(i)) ++i;
+			if (i == position) throw JsonParseError("invalid value", position);
+			return i;
+		}
+		}
+	}
+
+	Container& container(std::size_t position) { // lists the children of the object or array at `position` once
+		auto found = containers_.find(position);
+		if (found != containers_.end()) return found->second;
+		Container result;
+		bool object = text_[position] == '{';
+		char close = object ? '}' : ']';
+		std::size_t i = skipWhitespace(position + 1);
+		if (i < text_.size() && text_[i] == close) return containers_.emplace(position, std::move(result)).first->second;
+		for (;;) {
+			std::string_view key;
+			if (object) {
+				if (i >= text_.size() || text_[i] != '"') throw JsonParseError("expected a string key", i);
+				std::size_t end = closingQuote(i);
+				key = text_.substr(i + 1, end - i - 1);
+				if (key.find('\\') != std::string_view::npos) {
+					std::string& unescaped = unescapedKeys_.emplace_back();
+					parseString(i, unescaped);
+					key = unescaped;
+				}
+				i = skipWhitespace(end + 1);
+				if (i >= text_.size() || text_[i] != ':') throw JsonParseError("expected ':'", i);
+				i = skipWhitespace(i + 1);
+			}
+			if (i >= text_.size()) throw JsonParseError("unexpected end of input", i);
+			result.children.push_back({key, i});
+			i = skipWhitespace(valueEnd(i));
+			if (i < text_.size() && text_[i] == close) return containers_.emplace(position, std::move(result)).first->second;
+			if (i >= text_.size() || text_[i] != ',') {
+				throw JsonParseError(object ? "expected ',' or '}'" : "expected ',' or ']'", i < text_.size() ? i : position);
+			}
+			i = skipWhitespace(i + 1);
+		}
+	}
+
+	std::size_t root_;
+	std::unordered_map<std::size_t, Container> containers_; // keyed by the offset of the opening bracket
+	std::deque<std::string> unescapedKeys_;                  // the rare keys that could not be viewed in place
+};
+
+// Handle to one value of a JsonLazyDocument; cheap to copy. Same accessors as JsonCursor.
+class JsonLazyValue {
+public:
+	JsonType type() const {
+		switch (text()[position_]) {
+		case '{': return JsonType::Object;
+		case '[': return JsonType::Array;
+		case '"': return JsonType::String;
+		case 't': case 'f': return JsonType::Bool;
+		case 'n': return JsonType::Null;
+		default: return JsonType::Number;
+		}
+	}
+
+	double number() const { expect(JsonType::Number); return document_->parseNumber(position_); }
+	std::string string() const { expect(JsonType::String); return document_->parseString(position_); }
+	bool boolean() const {
+		expect(JsonType::Bool);
+		bool value = text()[position_] == 't';
+		document_->expectLiteral(position_, value ? "true" : "false");
+		return value;
+	}
+	bool isNull() const {
+		if (type() != JsonType::Null) return false;
+		document_->expectLiteral(position_, "null");
+		return true;
+	}
+
+	std::size_t size() const { return children().size(); }
+
+	template <typename Fn>
+	void forEachElement(Fn fn) const { // fn(JsonLazyValue element)
+		expect(JsonType::Array);
+		for (const auto& child : children()) fn(JsonLazyValue(document_, child.value));
+	}
+
+	template <typename Fn>
+	void forEachProperty(Fn fn) const { // fn(std::string_view key, JsonLazyValue value)
+		expect(JsonType::Object);
+		for (const auto& child : children()) fn(child.key, JsonLazyValue(document_, child.value));
+	}
+
+	JsonLazyValue operator[](std::size_t position) const { // array element, O(1) once the array is indexed
+		expect(JsonType::Array);
+		const auto& elements = children();
+		if (position >= elements.size()) throw std::out_of_range("JsonLazyValue: index out of range");
+		return JsonLazyValue(document_, elements[position].value);
+	}
+
+	std::optional<JsonLazyValue> find(std::string_view key) const { // first property named `key`
+		expect(JsonType::Object);
+		JsonLazyDocument::Container& object = document_->container(position_);
+		if (object.children.size() > JsonObject::indexThreshold) {
+			if (!object.byKey) {
+				object.byKey = std::make_unique<std::unordered_map<std::string_view, std::size_t>>();
+				object.byKey->reserve(object.children.size() * 2);
+				for (std::size_t i = 0; i < object.children.size(); ++i) object.byKey->emplace(object.children[i].key, i);
+			}
+			auto it = object.byKey->find(key);
+			if (it == object.byKey->end()) return std::nullopt;
+			return JsonLazyValue(document_, object.children[it->second].value);
+		}
+		for (const auto& child : object.children) {
+			if (child.key == key) return JsonLazyValue(document_, child.value);
+		}
+		return std::nullopt;
+	}
+
+	std::string_view raw() const { return text().substr(position_, document_->valueEnd(position_) - position_); }
+
+	// Full tree of this value only; parse error offsets are relative to raw().
+	std::shared_ptr<JsonValue> materialize() const { return JsonParser::parse(raw()); }
+
+private:
+	friend class JsonLazyDocument;
+	JsonLazyValue(JsonLazyDocument* document, std::size_t position) : document_{document}, position_{position} {}
+
+	std::string_view text() const { return document_->text_; }
+
+	const std::vector<JsonLazyDocument::Child>& children() const {
+		if (type() != JsonType::Object) expect(JsonType::Array);
+		return document_->container(position_).children;
+	}
+
+	void expect(JsonType wanted) const {
+		if (type() != wanted) throw std::runtime_error("JsonLazyValue: value has a different type");
+	}
+
+	JsonLazyDocument* document_;
+	std::size_t position_;
+};
+
+inline JsonLazyValue JsonLazyDocument::root() { return JsonLazyValue(this, root_); }
+
+// Pulls one top-level record at a time out of newline-delimited JSON or out of one huge top-level array, so
+// inputs much larger than memory can go through the JsonValue composite. With Format::Auto, input starting with
+// '[' is taken as one top-level array unless its first value closes within the first chunk and more values
+// follow it, as in NDJSON whose records are arrays; pass the format explicitly when records can be larger than
+// a chunk. Input is read in chunks from a file descriptor, pipes included, or mapped when a path names a regular
+// file; either way only the record being framed has to fit in the buffer, which grows just enough for the
+// largest one.
+// Records are framed with the stage 1 block classifier and parsed by JsonParser. Their nodes come from a
+// pool that goes back to it when the caller drops the record, so steady-state parsing reuses the previous
+// records' node storage. Every node co-owns the pool, so a record may outlive the reader.
+class JsonRecordReader : private JsonScanner {
+public:
+	enum class Format { Auto, Lines, Array };
+
+	static constexpr std::size_t defaultChunkSize = 1 << 20;
+
+	explicit JsonRecordReader(int fd, std::size_t chunkSize = defaultChunkSize, Format format = Format::Auto)
+		: JsonScanner({}, Unindexed{}), fd_{fd}, buffer_(std::max<std::size_t>(chunkSize, 64)), format_{format} {}
+
+	explicit JsonRecordReader(const std::string& path, Format format = Format::Auto)
+		: JsonScanner({}, Unindexed{}), format_{format} {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+		struct stat status;
+		if (::fstat(fd, &status) != 0) {
+			int error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), "fstat " + path);
+		}
+		if (!S_ISREG(status.st_mode)) { // FIFOs, /dev/stdin, procfs: st_size says nothing, so read them in chunks
+			fd_ = fd;
+			ownsFd_ = true;
+			buffer_.resize(defaultChunkSize);
+			return;
+		}
+		mappedSize_ = static_cast<std::size_t>(status.st_size);
+		if (mappedSize_ != 0) {
+			void* address = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address == MAP_FAILED) {
+				int error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), "mmap " + path);
+			}
+			mapped_ = static_cast<const char*>(address);
+			::madvise(address, mappedSize_, MADV_SEQUENTIAL);
+		}
+		::close(fd);
+		end_ = mappedSize_;
+		eof_ = true;
+	}
+
+	~JsonRecordReader() {
+		if (mapped_) ::munmap(const_cast<char*>(mapped_), mappedSize_);
+		if (ownsFd_) ::close(fd_);
+	}
+	JsonRecordReader(const JsonRecordReader&) = delete;
+	JsonRecordReader& operator=(const JsonRecordReader&) = delete;
+
+	// The next record parsed into a tree, or nullptr at the end of the input.
+	std::shared_ptr<JsonValue> next() {
+		std::optional<std::string_view> text = nextText();
+		return text ? JsonParser::parse(*text, nodes_) : nullptr;
+	}
+
+	// The next record's text, valid until the following call; parse errors inside it are left to the caller.
+	std::optional<std::string_view> nextText() {
+		for (;;) {
+			if (skipWhitespace() == end_) {
+				if (format_ == Format::Array && state_ != ArrayState::Closed) {
+					throw JsonParseError(arrayOpened_ ? "unterminated array" : "expected '['", offsetOf(end_));
+				}
+				return std::nullopt;
+			}
+			char c = data()[begin_];
+			if (format_ == Format::Auto) format_ = c == '[' && !firstValueIsRecord() ? Format::Array : Format::Lines;
+			if (format_ == Format::Array && !arrayOpened_) {
+				if (c != '[') throw JsonParseError("expected '['", offsetOf(begin_));
+				arrayOpened_ = true;
+				++begin_;
+				continue;
+			}
+			if (format_ == Format::Array) {
+				if (state_ == ArrayState::Closed) throw JsonParseError("trailing content", offsetOf(begin_));
+				if (state_ == ArrayState::Separator) {
+					if (c != ',' && c != ']') throw JsonParseError("expected ',' or ']'", offsetOf(begin_));
+					state_ = c == ',' ? ArrayState::Value : ArrayState::Closed;
+					++begin_;
+					continue;
+				}
+				if (c == ']' && state_ == ArrayState::First) {
+					state_ = ArrayState::Closed;
+					++begin_;
+					continue;
+				}
+				if (c == ',' || c == ']') throw JsonParseError("expected a value", offsetOf(begin_));
+				state_ = ArrayState::Separator;
+			}
+			std::size_t end = format_ == Format::Lines ? lineEnd() : elementEnd();
+			std::string_view record(data() + begin_, end - begin_);
+			begin_ = end;
+			++records_;
+			releaseConsumedPages();
+			return record;
+		}
+	}
+
+	// Parses records on `threads` workers while the calling thread only frames them. Records travel in batches
+	// of about batchBytes and at most 2 * threads batches are queued, so memory stays bounded no matter how
+	// large the input is. fn(recordNumber, const JsonValue& record) runs on the workers, in no particular order;
+	// the record lives in its worker's pool and is valid only until fn returns, so copy out what must be kept.
+	// The first exception thrown by a worker stops the run and is rethrown here.
+	template <typename Fn>
+	void forEachRecordParallel(unsigned threads, Fn fn, std::size_t batchBytes = 1 << 20) {
+		struct Batch {
+			std::string text;
+			std::vector<std::pair<std::size_t, std::size_t>> records; // offset and length in text
+			std::size_t firstRecord = 0;
+		};
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<Batch> queued, spare; // spare batches keep their capacity for reuse
+		bool finished = false;
+		std::exception_ptr failure;
+		const std::size_t maxQueued = 2 * std::max(threads, 1u);
+
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < std::max(threads, 1u); ++t) {
+			workers.emplace_back([&] {
+				std::pmr::unsynchronized_pool_resource nodes; // per worker: no locking on the node allocator
+				for (;;) {
+					Batch batch;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [&] { return !queued.empty() || finished || failure; });
+						if (queued.empty() || failure) return;
+						batch = std::move(queued.front());
+						queued.pop_front();
+					}
+					changed.notify_all();
+					try {
+						for (std::size_t i = 0; i < batch.records.size(); ++i) {
+							std::string_view text(batch.text.data() + batch.records[i].first, batch.records[i].second);
+							std::shared_ptr<const JsonValue> record = JsonParser::parse(text, &nodes); // released before the pool
+							fn(batch.firstRecord + i, *record);
+						}
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(mutex);
+						if (!failure) failure = std::current_exception();
+					}
+					batch.text.clear();
+					batch.records.clear();
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						spare.push_back(std::move(batch));
+					}
+					changed.notify_all();
+				}
+			});
+		}
+
+		auto publish = [&](Batch& batch) { // false once a worker has failed
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&] { return queued.size() < maxQueued || failure; });
+			if (failure) return false;
+			queued.push_back(std::move(batch));
+			if (spare.empty()) batch = Batch();
+			else {
+				batch = std::move(spare.front());
+				spare.pop_front();
+			}
+			lock.unlock();
+			changed.notify_all();
+			return true;
+		};
+
+		Batch batch;
+		try {
+			bool running = true;
+			while (running) {
+				std::optional<std::string_view> text = nextText();
+				if (text) {
+					if (batch.records.empty()) batch.firstRecord = records_ - 1;
+					batch.records.emplace_back(batch.text.size(), text->size());
+					batch.text.append(*text);
+				}
+				if (!batch.records.empty() && (!text || batch.text.size() >= batchBytes)) running = publish(batch);
+				if (!text) break;
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!failure) failure = std::current_exception();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished = true;
+		}
+		changed.notify_all();
+		for (auto& worker : workers) worker.join();
+		if (failure) std::rethrow_exception(failure);
+	}
+
+	std::size_t recordsRead() const { return records_; }
+	std::size_t bufferSize() const { return buffer_.size(); } // chunk size, or the largest record if that was bigger
+
+private:
+	enum class ArrayState { First, Value, Separator, Closed }; // Value: after ',', Separator: after an element
+
+	static constexpr std::size_t releaseBytes = 64 << 20; // mapped pages already parsed are dropped in steps of this
+
+	const char* data() const { return mapped_ ? mapped_ : buffer_.data(); }
+	std::size_t offsetOf(std::size_t position) const { return discarded_ + position; } // offset in the whole input
+
+	bool refill() { // false at the end of the input; may move the unconsumed bytes to the front of the buffer
+		if (eof_) return false;
+		if (begin_ > 0) {
+			std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+			end_ -= begin_;
+			discarded_ += begin_;
+			begin_ = 0;
+		}
+		if (end_ == buffer_.size()) buffer_.resize(buffer_.size() * 2); // a record longer than the buffer
+		for (;;) {
+			ssize_t n = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0) throw std::system_error(errno, std::generic_category(), "read");
+			if (n == 0) {
+				eof_ = true;
+				return false;
+			}
+			end_ += static_cast<std::size_t>(n);
+			return true;
+		}
+	}
+
+	std::size_t skipWhitespace() {
+		for (;;) {
+			while (begin_ < end_ && (data()[begin_] == ' ' || data()[begin_] == '\n' || data()[begin_] == '\r' || data()[begin_] == '\t')) ++begin_;
+			if (begin_ < end_ || !refill()) return begin_;
+		}
+	}
+
+	// Format::Auto on input starting with '[': true when that first value closes within the data already read
+	// and more non-whitespace follows it, so the input is a sequence of values rather than one array.
+	bool firstValueIsRecord() const {
+		std::size_t depth = 0;
+		bool inString = false;
+		for (std::size_t i = begin_; i < end_; ++i) {
+			char c = data()[i];
+			if (inString) {
+				if (c == '\\') ++i;
+				else if (c == '"') inString = false;
+			} else if (c == '"') {
+				inString = true;
+			} else if (c == '[' || c == '{') {
+				++depth;
+			} else if ((c == ']' || c == '}') && --depth == 0) {
+				for (++i; i < end_; ++i) {
+					c = data()[i];
+					if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return true;
+				}
+				return false;
+			}
+			if (mapped_ && i - begin_ >= defaultChunkSize) return false; // look no further into a mapping than a chunk
+		}
+		return false;
+	}
+
+	std::size_t lineEnd() { // a raw newline cannot occur inside a JSON value, so the first one ends the record
+		std::size_t scanned = 0;
+		for (;;) {
+			const void* newline = std::memchr(data() + begin_ + scanned, '\n', end_ - begin_ - scanned);
+			if (newline) return static_cast<std::size_t>(static_cast<const char*>(newline) - data());
+			scanned = end_ - begin_;
+			if (!refill()) return end_;
+		}
+	}
+
+	std::size_t elementEnd() { // the ',' or ']' that ends the array element starting at begin_
+		BlockState state;
+		const ClassifyFn classify = classifier();
+		std::size_t depth = 0;
+		std::size_t scanned = 0; // whole blocks already classified, relative to begin_ so refill() can move them
+		char padded[64];
+		for (;;) {
+			while (begin_ + scanned + 64 <= end_ || (eof_ && begin_ + scanned < end_)) {
+				const char* block = data() + begin_ + scanned;
+				if (begin_ + scanned + 64 > end_) { // last partial block, padded with spaces
+					std::memset(padded, ' ', sizeof(padded));
+					std::memcpy(padded, block, end_ - begin_ - scanned);
+					block = padded;
+				}
+				BlockMasks masks = classify(block);
+				std::uint64_t outside = masks.op & ~insideStrings(unescapedQuotes(masks, state), state);
+				for (; outside != 0; outside &= outside - 1) {
+					std::size_t bit = static_cast<std::size_t>(__builtin_ctzll(outside));
+					char c = block[bit];
+					if (c == '{' || c == '[') ++depth;
+					else if ((c == '}' || c == ']') && depth > 0) --depth;
+					else if (c == ']' || (c == ',' && depth == 0)) return begin_ + scanned + bit;
+				}
+				scanned += 64;
+			}
+			if (!refill() && begin_ + scanned >= end_) {
+				throw JsonParseError(state.inString ? "unterminated string" : "unterminated array", offsetOf(begin_));
+			}
+		}
+	}
+
+	void releaseConsumedPages() { // keeps the resident size of a mapped input bounded
+		if (!mapped_ || begin_ - released_ < releaseBytes) return;
+		std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		std::size_t length = (begin_ - released_) / page * page;
+		::madvise(const_cast<char*>(mapped_) + released_, length, MADV_DONTNEED);
+		released_ += length;
+	}
+
+	int fd_ = -1;
+	bool ownsFd_ = false;       // opened by the path constructor for a file that cannot be mapped
+	std::vector<char> buffer_;
+	const char* mapped_ = nullptr;
+	std::size_t mappedSize_ = 0;
+	std::size_t released_ = 0;  // mapped bytes handed back to the kernel
+	std::size_t begin_ = 0;     // first unconsumed byte of data()
+	std::size_t end_ = 0;       // one past the last valid byte of data()
+	std::size_t discarded_ = 0; // input bytes moved out of the front of buffer_
+	bool eof_ = false;
+	Format format_ = Format::Auto;
+	bool arrayOpened_ = false;  // the '[' of a Format::Array input has been consumed
+	ArrayState state_ = ArrayState::First;
+	std::size_t records_ = 0;
+	std::shared_ptr<std::pmr::memory_resource> nodes_ = std::make_shared<std::pmr::synchronized_pool_resource>(); // records may be dropped on any thread
+};
+
+////////////////////////// Benchmark //////////////////////////
+// ./composite_004 --bench : parser throughput on three synthetic corpora shaped like the usual JSON
+// benchmark files (twitter.json: string-heavy objects, canada.json: coordinate arrays, citm_catalog.json:
+// integer-heavy nested objects).
+std::string twitterLikeCorpus(std::size_t targetSize) {
+	std::string json = "{\"statuses\":[";
+	for (std::size_t i = 0; json.size() < targetSize; ++i) {
+		if (i) json += ',';
+		json += "{\"id\":" + std::to_string(505874924095815681ULL + i) + ",\"text\":\"@aym0566x \\n\\u540d\\u524d:\\u524d\\u7530\\u3042\\u3086\\u307f "
+			"Caf\xC3\xA9 \\\"quoted\\\" text with a link https:\\/\\/t.co\\/" + std::to_string(i) + " and some more words to make it realistic\","
+			"\"user\":{\"id\":" + std::to_string(1186275104 + i) + ",\"name\":\"\xE3\x81\x84\xE3\x81\x95\",\"screen_name\":\"ayuu0123\","
+			"\"followers_count\":" + std::to_string(262 + i % 1000) + ",\"verified\":false,\"location\":null,\"lang\":\"ja\"},"
+			"\"entities\":{\"hashtags\":[],\"user_mentions\":[{\"screen_name\":\"aym0566x\",\"indices\":[0,9]}]},"
+			"\"retweet_count\":" + std::to_string(i % 50) + ",\"favorited\":false,\"lang\":\"ja\"}";
+	}
+	return json + "]}";
+}
+
+std::string canadaLikeCorpus(std::size_t targetSize) {
+	std::string json = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[";
+	char point[64];
+	for (std::size_t i = 0; json.size() < targetSize; ++i) {
+		std::snprintf(point, sizeof(point), "%s[%.15f,%.15f]", i ? "," : "", -65.613616999999977 + i * 1e-6, 43.420273000000009 - i * 1e-6);
+		json += point;
+	}
+	return json + "]]}}]}";
+}
+
+std::string citmLikeCorpus(std::size_t targetSize) {
+	std::string json = "{\"events\":{";
+	for (std::size_t i = 0; json.size() < targetSize; ++i) {
+		std::string id = std::to_string(138586341 + i);
+		json += (i ? ",\"" : "\"") + id + "\":{\"description\":null,\"id\":" + id + ",\"logo\":null,\"name\":\"30th Anniversary Tour\","
+			"\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[324846099,107888604],"
+			"\"prices\":[{\"amount\":90250,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":338937295},"
+			"{\"amount\":66500,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":338937296}]}";
+	}
+	return json + "}}";
+}
+
+template <typename Fn>
+double bestSeconds(int runs, Fn fn) {
+	double best = 1e30;
+	for (int i = 0; i < runs; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+std::size_t heapInUse() { // bytes currently handed out by malloc; 0 where glibc's mallinfo2 is unavailable
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+std::shared_ptr<JsonValue> treeAt(std::shared_ptr<JsonValue> value, const std::vector<std::string>& path) {
+	for (const std::string& segment : path) {
+		if (auto object = std::dynamic_pointer_cast<JsonObject>(value)) value = object->find(segment);
+		else value = std::static_pointer_cast<JsonArray>(value)->at(std::stoul(segment));
+		if (!value) throw std::out_of_range("no property " + segment);
+	}
+	return value;
+}
+
+JsonLazyValue lazyAt(JsonLazyValue value, const std::vector<std::string>& path) {
+	for (const std::string& segment : path) {
+		if (value.type() != JsonType::Object) value = value[std::stoul(segment)];
+		else if (auto found = value.find(segment)) value = *found;
+		else throw std::out_of_range("no property " + segment);
+	}
+	return value;
+}
+
+// Reads three fields, the typical consumer, once from a fully materialized tree and once from a lazy document.
+// Heap is what the document holds while the fields are read, not counting the process-wide key pool.
+void benchmarkLazyAccess() {
+	const std::size_t size = 16 * 1024 * 1024;
+	struct Case {
+		const char* name;
+		std::string text;
+		std::vector<std::vector<std::string>> paths;
+	};
+	Case cases[] = {
+		{"twitter-like", twitterLikeCorpus(size),
+			{{"statuses", "1000", "user", "screen_name"}, {"statuses", "10000", "retweet_count"}, {"statuses", "20000", "entities", "user_mentions", "0", "indices", "1"}}},
+		{"canada-like", canadaLikeCorpus(size),
+			{{"type"}, {"features", "0", "geometry", "type"}, {"features", "0", "geometry", "coordinates", "0", "5000", "1"}}},
+		{"citm-like", citmLikeCorpus(size),
+			{{"events", "138586341", "name"}, {"events", "138596341", "prices", "1", "amount"}, {"events", "138616341", "topicIds", "0"}}},
+	};
+	std::printf("%-14s %10s %10s %10s %10s %12s\n", "corpus", "tree ms", "tree MB", "lazy ms", "lazy MB", "containers");
+	for (const Case& c : cases) {
+		std::string treeFields, lazyFields;
+		std::size_t treeBytes = 0, lazyBytes = 0, containers = 0;
+		double tree = bestSeconds(3, [&] {
+			std::size_t before = heapInUse();
+			std::shared_ptr<JsonValue> root = JsonParser::parse(c.text);
+			treeFields.clear();
+			for (const auto& path : c.paths) treeFields += treeAt(root, path)->toString() + ' ';
+			treeBytes = heapInUse() - std::min(before, heapInUse());
+		});
+		double lazy = bestSeconds(3, [&] {
+			std::size_t before = heapInUse();
+			JsonLazyDocument document(c.text);
+			lazyFields.clear();
+			for (const auto& path : c.paths) lazyFields += lazyAt(document.root(), path).materialize()->toString() + ' ';
+			lazyBytes = heapInUse() - std::min(before, heapInUse());
+			containers = document.containersIndexed();
+		});
+		std::printf("%-14s %10.2f %10.2f %10.2f %10.3f %12zu%s\n", c.name, tree * 1e3, treeBytes / 1e6, lazy * 1e3, lazyBytes / 1e6,
+					containers, treeFields == lazyFields ? "" : "  (field mismatch!)");
+	}
+}
+
+// Streams 64 MB of twitter-like records from a temporary file, as NDJSON and as one top-level array, and
+// compares the heap held while streaming with parsing the whole array into one tree.
+void benchmarkStreaming() {
+	std::string lines, array = "[";
+	{
+		std::string corpus = twitterLikeCorpus(64 * 1024 * 1024);
+		JsonLazyDocument document(corpus);
+		document.root().find("statuses")->forEachElement([&](JsonLazyValue status) {
+			if (array.size() > 1) array += ',';
+			array += status.raw();
+			lines += status.raw();
+			lines += '\n';
+		});
+	}
+	array += ']';
+	std::FILE* linesFile = std::tmpfile();
+	std::FILE* arrayFile = std::tmpfile();
+	std::fwrite(lines.data(), 1, lines.size(), linesFile);
+	std::fwrite(array.data(), 1, array.size(), arrayFile);
+	std::fflush(linesFile);
+	std::fflush(arrayFile);
+	const std::size_t bytes = array.size();
+	lines = std::string();
+
+	std::printf("%-26s %10s %12s %14s\n", "mode", "GB/s", "records", "peak heap MB");
+	auto report = [&](const char* mode, double seconds, std::size_t records, std::size_t peak, std::size_t before) {
+		std::printf("%-26s %10.3f %12zu %14.1f\n", mode, bytes / seconds / 1e9, records, (peak - std::min(peak, before)) / 1e6);
+	};
+	auto sequential = [&](const char* mode, auto openReader) {
+		std::size_t before = heapInUse(), peak = before, records = 0;
+		double seconds = bestSeconds(1, [&] {
+			auto reader = openReader();
+			while (std::shared_ptr<JsonValue> record = reader->next()) {
+				if (!std::static_pointer_cast<JsonObject>(record)->contains("retweet_count")) throw std::runtime_error("record without retweet_count");
+				if (++records % 1024 == 0) peak = std::max(peak, heapInUse());
+			}
+		});
+		report(mode, seconds, records, peak, before);
+	};
+	auto fromFd = [](std::FILE* file) {
+		::lseek(fileno(file), 0, SEEK_SET);
+		return std::make_unique<JsonRecordReader>(fileno(file));
+	};
+	auto fromMapping = [](std::FILE* file) { return std::make_unique<JsonRecordReader>("/proc/self/fd/" + std::to_string(fileno(file))); };
+	sequential("NDJSON, read()", [&] { return fromFd(linesFile); });
+	sequential("NDJSON, mmap", [&] { return fromMapping(linesFile); });
+	sequential("top-level array, read()", [&] { return fromFd(arrayFile); });
+	sequential("top-level array, mmap", [&] { return fromMapping(arrayFile); });
+	for (unsigned threads = 1; threads <= std::max(4u, std::thread::hardware_concurrency()); threads *= 2) {
+		std::size_t before = heapInUse();
+		std::atomic<std::size_t> records{0}, peak{before};
+		double seconds = bestSeconds(1, [&] {
+			fromFd(linesFile)->forEachRecordParallel(threads, [&](std::size_t, const JsonValue&) {
+				if (++records % 1024 == 0) peak = std::max(peak.load(), heapInUse());
+			});
+		});
+		std::string mode = "NDJSON, " + std::to_string(threads) + " worker" + (threads > 1 ? "s" : "");
+		report(mode.c_str(), seconds, records, peak, before);
+	}
+	std::size_t before = heapInUse();
+	std::shared_ptr<JsonValue> whole;
+	double seconds = bestSeconds(1, [&] { whole = JsonParser::parse(array); });
+	report("whole array in one tree", seconds, std::static_pointer_cast<JsonArray>(whole)->size(), heapInUse(), before);
+	std::fclose(linesFile);
+	std::fclose(arrayFile);
+}
+
+void benchmarkNumberFormatting() { // time-series style values: what dominates numeric-heavy exports
+	std::vector<double> values;
+	for (int i = 0; i < 1000000; ++i) values.push_back(i % 4 == 0 ? i : 1600000000.0 + i * 0.001 + 1.0 / (i + 3));
+	std::size_t sink = 0;
+	double toString = bestSeconds(3, [&] { for (double v : values) sink += std::to_string(v).size(); });
+	char buffer[32];
+	double shortest = bestSeconds(3, [&] { for (double v : values) sink += formatNumber(v, buffer); });
+	std::size_t exact = 0;
+	for (double v : values) {
+		double back = 0.0;
+		std::size_t length = formatNumber(v, buffer);
+		std::from_chars(buffer, buffer + length, back);
+		exact += back == v;
+	}
+	std::printf("std::to_string %.1f ns/number, formatNumber %.1f ns/number, %zu/%zu round trip exactly (%zu chars)\n",
+				toString * 1e9 / values.size(), shortest * 1e9 / values.size(), exact, values.size(), sink);
+}
+
+void benchmarkParser() {
+	const std::size_t size = 16 * 1024 * 1024;
+	std::pair<const char*, std::string> corpora[] = {
+		{"twitter-like", twitterLikeCorpus(size)}, {"canada-like", canadaLikeCorpus(size)}, {"citm-like", citmLikeCorpus(size)}};
+	std::printf("%-14s %8s %14s %14s %14s %10s\n", "corpus", "MB", "stage 1 GB/s", "tree GB/s", "tape GB/s", "tape MB");
+	for (const auto& [name, text] : corpora) {
+		double gigabytes = text.size() / 1e9;
+		double index = bestSeconds(5, [&] { volatile std::size_t n = JsonParser::indexStructurals(text).size(); (void)n; });
+		std::shared_ptr<JsonValue> tree;
+		double parse = bestSeconds(3, [&] { tree = JsonParser::parse(text); });
+		JsonWriter writer;
+		tree->serialize(writer);
+		JsonTape tape;
+		double tapeParse = bestSeconds(3, [&] { tape = JsonTape::parse(text); });
+		bool roundTrip = JsonParser::parse(writer.str())->toString() == tree->toString()
+			&& tape.toTree()->toString() == tree->toString() && JsonTape::fromTree(*tree).toTree()->toString() == tree->toString();
+		std::printf("%-14s %8.1f %14.2f %14.2f %14.2f %10.1f%s\n", name, text.size() / 1e6, gigabytes / index, gigabytes / parse,
+					gigabytes / tapeParse, tape.bytesAllocated() / 1e6, roundTrip ? "" : "  (round trip mismatch!)");
+	}
+}
+//////////////////////////////////////////////
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && std::string(argv[1]) == "--bench") {
+		benchmarkParser();
+		benchmarkLazyAccess();
+		benchmarkStreaming();
+		benchmarkNumberFormatting();
+		return 0;
+	}
+
+	auto jsonNumber = std::make_shared<JsonNumber>(3.14);
+	auto jsonString = std::make_shared<JsonString>("hello");
+	auto jsonArray = std::make_shared<JsonArray>();
+	jsonArray->add(std::make_shared<JsonString>("world"));
+	jsonArray->add(std::make_shared<JsonNumber>(42));
+	auto jsonObject = std::make_shared<JsonObject>();
+	jsonObject->add("number", jsonNumber);
+	jsonObject->add("string", jsonString);
+	jsonObject->add("array", jsonArray);
+	jsonObject->add("null", std::make_shared<JsonNull>());
+	std::cout << jsonObject->toString() << std::endl;
+	// {"number":3.14,"string":"hello","array":["world",42],"null":null}
+
+	JsonWriter compact; // one buffer, reused for every document serialized through it
+	jsonObject->serialize(compact);
+	std::cout << (compact.str() == jsonObject->toString() ? "identical" : "different") << std::endl; // identical
+
+	{
+		JsonWriter pretty(JsonWriter::Mode::Pretty, STDOUT_FILENO); // streamed straight to the file descriptor
+		jsonObject->serialize(pretty);
+		pretty.write('\n');
+		pretty.flush(); // throws on a write error, which the destructor could only drop
+	}
+	// {
+	//   "number": 3.14,
+	//   "string": "hello",
+	//   "array": [
+	//     "world",
+	//     42
+	//   ],
+	//   "null": null
+	// }
+
+	auto parsed = JsonParser::parse(R"( {"name": "caf\u00e9 \"bar\"", "tags": ["a", "b"], "open": true, "rating": 4.5, "owner": null} )");
+	std::cout << parsed->toString() << std::endl;
+	// {"name":"café \"bar\"","tags":["a","b"],"open":true,"rating":4.5,"owner":null}
+	try {
+		JsonParser::parse("{\"name\": \"unterminated}");
+	} catch (const JsonParseError& error) {
+		std::cout << error.what() << std::endl; // unterminated string at offset 23
+	}
+
+	JsonTape tape = JsonTape::parse(R"({"sensor": "t-101", "readings": [21.5, 21.7, 22.0], "calibrated": false})"); // one allocation
+	JsonCursor readings = *tape.root().find("readings");
+	double sum = 0.0;
+	readings.forEachElement([&](JsonCursor reading) { sum += reading.number(); });
+	std::cout << tape.root().find("sensor")->string() << " average " << sum / readings.size() << std::endl; // t-101 average 21.7333
+	std::cout << JsonTape::fromTree(*jsonObject).toTree()->toString() << std::endl; // same as jsonObject->toString()
+
+	auto catalog = std::static_pointer_cast<JsonObject>(JsonParser::parse(citmLikeCorpus(64 * 1024)));
+	auto events = std::static_pointer_cast<JsonObject>(catalog->find("events")); // hundreds of keys: hashed lookup
+	auto event = std::static_pointer_cast<JsonObject>(events->find("138586341"));
+	(*event)["logo"] = std::make_shared<JsonString>("logo.png"); // small object: linear scan, order unchanged
+	std::cout << events->size() << " events, " << JsonKeyPool::size() << " distinct keys, first logo "
+			  << event->find("logo")->toString() << ", has venue: " << std::boolalpha << event->contains("venue") << std::endl;
+	// 182 events, 203 distinct keys, first logo "logo.png", has venue: false
+
+	std::string payload = twitterLikeCorpus(1024 * 1024);
+	JsonLazyDocument lazy(payload); // nothing parsed yet
+	JsonLazyValue status = lazy.root().find("statuses")->operator[](100);
+	std::cout << status.find("user")->find("screen_name")->string() << " has " << status.find("retweet_count")->number()
+			  << " retweets (" << lazy.containersIndexed() << " containers indexed)" << std::endl;
+	// ayuu0123 has 0 retweets (4 containers indexed)
+
+	std::FILE* ndjson = std::tmpfile(); // stands in for a file far larger than memory
+	std::fputs("{\"sensor\": \"t-101\", \"value\": 21.5}\n{\"sensor\": \"t-102\", \"value\": 19.25}\n{\"sensor\": \"t-103\", \"value\": 22}\n", ndjson);
+	std::fflush(ndjson);
+	::lseek(fileno(ndjson), 0, SEEK_SET);
+	JsonRecordReader records(fileno(ndjson), 16); // tiny chunks: records straddle every read
+	while (std::shared_ptr<JsonValue> record = records.next()) {
+		std::cout << std::static_pointer_cast<JsonObject>(record)->find("value")->toString() << ' '; // one record in memory at a time
+	}
+	std::cout << "from " << records.recordsRead() << " records" << std::endl; // 21.5 19.25 22 from 3 records
+	std::fclose(ndjson);
+
+	int pipeFds[2]; // a pipe opened by path: fstat() reports size 0, so it is read rather than mapped
+	if (::pipe(pipeFds) == 0) {
+		std::string arrays = "[1, 2]\n[3, [4]]\n";
+		ssize_t written = ::write(pipeFds[1], arrays.data(), arrays.size());
+		::close(pipeFds[1]);
+		if (written == static_cast<ssize_t>(arrays.size())) {
+			JsonRecordReader arrayRecords("/proc/self/fd/" + std::to_string(pipeFds[0])); // NDJSON of arrays, not one array
+			while (std::shared_ptr<JsonValue> record = arrayRecords.next()) std::cout << record->toString() << ' ';
+			std::cout << "from " << arrayRecords.recordsRead() << " records" << std::endl; // [1,2] [3,[4]] from 2 records
+		}
+		::close(pipeFds[0]);
+	}
 	return 0;
 }
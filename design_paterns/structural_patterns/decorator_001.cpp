@@ -31,6 +31,9 @@
 
 #include <iostream>
 #include <memory>
+#include <chrono>
+#include <type_traits>
+#include <utility>
 
 using namespace std;
 
@@ -87,11 +90,180 @@ public:
 	}
 };
 
+// Compile-time decorators: when a stack is fixed at build time, each decorator can be a class template that
+// derives from the layer it decorates (a mixin) instead of holding a pointer to it. Base::operation() is a
+// qualified, non-virtual call, so the compiler inlines the whole stack into a single operation() call.
+template <typename Base>
+class DecoratorA : public Base {
+public:
+	using Base::Base;
+
+	void operation() {
+		Base::operation();
+		addedBehavior();
+	}
+
+	void addedBehavior() {
+		cout << "DecoratorA addedBehavior called." << endl;
+	}
+};
+
+template <typename Base>
+class DecoratorB : public Base {
+public:
+	using Base::Base;
+
+	void operation() {
+		Base::operation();
+		addedBehavior();
+	}
+
+	void addedBehavior() {
+		cout << "DecoratorB addedBehavior called." << endl;
+	}
+};
+
+// Decorated<ConcreteComponent, DecoratorA, DecoratorB> is DecoratorB<DecoratorA<ConcreteComponent>>: decorators
+// are listed innermost first, in the same order the dynamic chain wraps them.
+template <typename Core, template <typename> class... Decorators>
+struct DecoratorStack {
+	using type = Core;
+};
+
+template <typename Core, template <typename> class First, template <typename> class... Rest>
+struct DecoratorStack<Core, First, Rest...> {
+	using type = typename DecoratorStack<First<Core>, Rest...>::type;
+};
+
+template <typename Core, template <typename> class... Decorators>
+using Decorated = typename DecoratorStack<Core, Decorators...>::type;
+
+// Hands a static stack to code written against Component, for one virtual call per operation() in total.
+template <typename Stack>
+class ComponentAdapter : public Component {
+public:
+	template <typename... Args>
+	ComponentAdapter(Args&&... args) : stack_(forward<Args>(args)...) {}
+
+	void operation() override {
+		stack_.operation();
+	}
+
+	Stack& stack() {
+		return stack_;
+	}
+
+private:
+	Stack stack_;
+};
+
+// A stack built on a Component is already a Component; anything else goes through ComponentAdapter.
+template <typename Stack, typename... Args>
+unique_ptr<Component> asComponent(Args&&... args) {
+	if constexpr (is_base_of_v<Component, Stack>) {
+		return make_unique<Stack>(forward<Args>(args)...);
+	} else {
+		return make_unique<ComponentAdapter<Stack>>(forward<Args>(args)...);
+	}
+}
+
+////////////////////////// Benchmark //////////////////////////
+// Every layer does the same xorshift step in both versions, so the difference is the per-layer call overhead:
+// a virtual call and a pointer chase in the dynamic chain (which also forces the state through memory at every
+// layer), nothing once the static stack is inlined.
+unsigned long long benchmarkState = 1;
+
+class CountingComponent : public Component {
+public:
+	void operation() override {
+		benchmarkState += 1;
+	}
+};
+
+class CountingDecorator : public Decorator {
+public:
+	CountingDecorator(unique_ptr<Component> component) : Decorator(move(component)) {}
+
+	void operation() override {
+		Decorator::operation();
+		benchmarkState ^= benchmarkState << 13;
+		benchmarkState ^= benchmarkState >> 7;
+	}
+};
+
+struct CountingCore {
+	void operation() {
+		benchmarkState += 1;
+	}
+};
+
+template <typename Base>
+class Counting : public Base {
+public:
+	void operation() {
+		Base::operation();
+		benchmarkState ^= benchmarkState << 13;
+		benchmarkState ^= benchmarkState >> 7;
+	}
+};
+
+template <typename Core, int Depth>
+struct CountingStack {
+	using type = typename CountingStack<Counting<Core>, Depth - 1>::type;
+};
+
+template <typename Core>
+struct CountingStack<Core, 0> {
+	using type = Core;
+};
+
+template <typename Fn>
+double nanosecondsPerCall(int calls, Fn fn) {
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < calls; ++i) {
+		fn();
+	}
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / calls;
+}
+
+template <int Depth>
+void compareStacks(int calls) {
+	unique_ptr<Component> dynamicChain = make_unique<CountingComponent>();
+	for (int i = 0; i < Depth; ++i) {
+		dynamicChain = make_unique<CountingDecorator>(move(dynamicChain));
+	}
+	typename CountingStack<CountingCore, Depth>::type staticStack;
+	unique_ptr<Component> adapted = asComponent<typename CountingStack<CountingCore, Depth>::type>();
+
+	double dynamicNs = nanosecondsPerCall(calls, [&] { dynamicChain->operation(); });
+	double staticNs = nanosecondsPerCall(calls, [&] { staticStack.operation(); });
+	double adaptedNs = nanosecondsPerCall(calls, [&] { adapted->operation(); });
+	cout << "Depth " << Depth << ": dynamic " << dynamicNs << " ns, static " << staticNs << " ns, static via Component "
+		 << adaptedNs << " ns" << endl;
+}
+//////////////////////////////////////////////
+
 int main() {
 	unique_ptr<Component> component = make_unique<ConcreteComponent>();
 	unique_ptr<Component> decoratorA = make_unique<ConcreteDecoratorA>(move(component));
 	unique_ptr<Component> decoratorB = make_unique<ConcreteDecoratorB>(move(decoratorA));
 
 	decoratorB->operation();
+
+	// The same stack composed at compile time, called directly...
+	Decorated<ConcreteComponent, DecoratorA, DecoratorB> stacked;
+	stacked.operation();
+
+	// ...and handed to code that only knows the dynamic interface, where it can be wrapped further at runtime.
+	unique_ptr<Component> mixed = make_unique<ConcreteDecoratorA>(asComponent<Decorated<ConcreteComponent, DecoratorA, DecoratorB>>());
+	mixed->operation();
+
+	const int calls = 2000000;
+	compareStacks<1>(calls);
+	compareStacks<2>(calls);
+	compareStacks<4>(calls);
+	compareStacks<8>(calls);
+	compareStacks<16>(calls);
+	compareStacks<32>(calls);
 	return 0;
 }
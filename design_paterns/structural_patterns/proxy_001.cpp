@@ -47,6 +47,18 @@
 
 #include <iostream>
 #include <string>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
 
 class Subject {
 public:
@@ -61,25 +73,190 @@ public:
 	}
 };
 
+// Safe to share between threads: the RealSubject is created exactly once, by the first caller that finds it
+// missing (double-checked locking). Once it exists, request() costs one acquire load and takes no lock.
+// With prewarm, construction starts on a background thread as soon as the proxy is created, so the first
+// request finds the subject ready (or waits only for the construction already under way).
 class Proxy : public Subject {
 public:
-	Proxy() : m_realSubject(nullptr) {}
+	explicit Proxy(bool prewarm = false) : m_realSubject(nullptr) {
+		if (prewarm) {
+			m_prewarm = std::thread([this] { realSubject(); });
+		}
+	}
 
 	~Proxy() {
-		delete m_realSubject;
+		if (m_prewarm.joinable()) {
+			m_prewarm.join();
+		}
+		delete m_realSubject.load(std::memory_order_acquire);
 	}
 
 	void request() override {
-		if (!m_realSubject) {
+		RealSubject* realSubject = this->realSubject();
+		std::cout << "Proxy: Forwarding request to RealSubject object." << std::endl;
+		realSubject->request();
+	}
+
+private:
+	RealSubject* realSubject() {
+		RealSubject* realSubject = m_realSubject.load(std::memory_order_acquire);
+		if (realSubject) {
+			return realSubject;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		realSubject = m_realSubject.load(std::memory_order_relaxed); // another thread may have won the race
+		if (!realSubject) {
 			std::cout << "Proxy: Creating a RealSubject object." << std::endl;
-			m_realSubject = new RealSubject;
+			realSubject = new RealSubject;
+			m_realSubject.store(realSubject, std::memory_order_release);
 		}
-		std::cout << "Proxy: Forwarding request to RealSubject object." << std::endl;
-		m_realSubject->request();
+		return realSubject;
+	}
+
+	std::atomic<RealSubject*> m_realSubject;
+	std::mutex m_mutex; // only taken while the RealSubject does not exist yet
+	std::thread m_prewarm;
+};
+
+// Caching proxy: memoizes the results of an expensive Subject call, Value (Subject::*)(const Key&).
+//  - Bounded: each shard keeps its share of `capacity` entries and evicts its least recently used one.
+//  - Optional TTL: an entry older than `ttl` counts as a miss and is recomputed (zero means no expiry).
+//  - Sharded: keys are spread over independent locks, so callers on different keys do not serialize.
+//  - Single-flight: concurrent misses on one key run the computation once; the others wait for its result.
+//    An exception thrown by the computation reaches every waiter and nothing is cached.
+template <typename Subject, typename Key, typename Value>
+class CachingProxy {
+public:
+	using Compute = Value (Subject::*)(const Key&);
+	using Clock = std::chrono::steady_clock;
+
+	struct Stats {
+		std::uint64_t hits;
+		std::uint64_t misses;     // computations started
+		std::uint64_t coalesced;  // misses that waited for another caller's computation
+		std::uint64_t evictions;  // entries dropped for capacity or because they expired
+	};
+
+	CachingProxy(Subject& subject, Compute compute, std::size_t capacity, Clock::duration ttl = Clock::duration::zero(), std::size_t shards = 16)
+		: m_subject(subject), m_compute(compute), m_ttl(ttl) {
+		shards = std::max<std::size_t>(1, std::min(shards, capacity));
+		for (std::size_t i = 0; i < shards; ++i) m_shards.push_back(std::make_unique<Shard>());
+		m_shardCapacity = (capacity + shards - 1) / shards;
+	}
+
+	Value get(const Key& key) {
+		Shard& shard = *m_shards[std::hash<Key>{}(key) % m_shards.size()];
+		std::promise<Value> promise;
+		std::shared_future<Value> flight;
+		{
+			std::unique_lock<std::mutex> lock(shard.mutex);
+			auto found = shard.index.find(key);
+			if (found != shard.index.end()) {
+				if (m_ttl == Clock::duration::zero() || Clock::now() < found->second->expires) {
+					shard.lru.splice(shard.lru.begin(), shard.lru, found->second); // now most recently used
+					m_hits.fetch_add(1, std::memory_order_relaxed);
+					return found->second->value;
+				}
+				shard.lru.erase(found->second);
+				shard.index.erase(found);
+				m_evictions.fetch_add(1, std::memory_order_relaxed);
+			}
+			auto running = shard.inFlight.find(key);
+			if (running != shard.inFlight.end()) {
+				flight = running->second;
+				lock.unlock();
+				m_coalesced.fetch_add(1, std::memory_order_relaxed);
+				return flight.get();
+			}
+			flight = promise.get_future().share();
+			shard.inFlight.emplace(key, flight);
+		}
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		try {
+			Value value = (m_subject.*m_compute)(key);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.inFlight.erase(key);
+			insert(shard, key, value);
+			promise.set_value(value);
+			return value;
+		} catch (...) {
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				shard.inFlight.erase(key);
+			}
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+	}
+
+	Stats stats() const {
+		return {m_hits.load(), m_misses.load(), m_coalesced.load(), m_evictions.load()};
 	}
 
 private:
-	RealSubject* m_realSubject;
+	struct Entry {
+		Key key;
+		Value value;
+		Clock::time_point expires;
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		std::list<Entry> lru; // most recently used first
+		std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+		std::unordered_map<Key, std::shared_future<Value>> inFlight;
+	};
+
+	void insert(Shard& shard, const Key& key, const Value& value) { // shard.mutex held
+		shard.lru.push_front({key, value, Clock::now() + m_ttl});
+		shard.index[key] = shard.lru.begin();
+		while (shard.lru.size() > m_shardCapacity) {
+			shard.index.erase(shard.lru.back().key);
+			shard.lru.pop_back();
+			m_evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	Subject& m_subject;
+	Compute m_compute;
+	Clock::duration m_ttl;
+	std::size_t m_shardCapacity;
+	std::vector<std::unique_ptr<Shard>> m_shards;
+	std::atomic<std::uint64_t> m_hits{0};
+	std::atomic<std::uint64_t> m_misses{0};
+	std::atomic<std::uint64_t> m_coalesced{0};
+	std::atomic<std::uint64_t> m_evictions{0};
+};
+
+// An expensive subject: every quote takes a slow round trip.
+class QuoteService {
+public:
+	virtual ~QuoteService() {}
+	virtual double quote(const std::string& symbol) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		m_lookups.fetch_add(1);
+		return 100.0 + static_cast<double>(symbol.size());
+	}
+	int lookups() const { return m_lookups.load(); }
+
+private:
+	std::atomic<int> m_lookups{0};
+};
+
+// Same interface as QuoteService, answered from the cache when possible.
+class CachedQuoteService : public QuoteService {
+public:
+	explicit CachedQuoteService(QuoteService& service)
+		: m_cache(service, &QuoteService::quote, 2, std::chrono::seconds(30), 1) {} // tiny on purpose: one shard of two quotes
+
+	double quote(const std::string& symbol) override {
+		return m_cache.get(symbol);
+	}
+	CachingProxy<QuoteService, std::string, double>::Stats stats() const { return m_cache.stats(); }
+
+private:
+	CachingProxy<QuoteService, std::string, double> m_cache;
 };
 
 int main() {
@@ -87,12 +264,34 @@ int main() {
 	proxy.request();
 	proxy.request();
 
+	Proxy prewarmed(true); // the RealSubject is built in the background right away
+	prewarmed.request();
+
+
+	QuoteService service;
+	CachedQuoteService cached(service);
+	std::vector<std::thread> clients;
+	for (int i = 0; i < 8; ++i) {
+		clients.emplace_back([&] { cached.quote("ACME"); }); // 8 concurrent misses, one lookup
+	}
+	for (auto& client : clients) client.join();
+	cached.quote("ACME");
+	cached.quote("GLOBEX");
+	cached.quote("INITECH"); // capacity 2: evicts the least recently used quote
+	auto stats = cached.stats();
+	std::cout << "Lookups: " << service.lookups() << ", hits: " << stats.hits << ", misses: " << stats.misses
+			  << ", coalesced: " << stats.coalesced << ", evictions: " << stats.evictions << std::endl;
+
 	//////////// output //////////
 	// Proxy: Creating a RealSubject object.
 	// Proxy: Forwarding request to RealSubject object.
 	// RealSubject: Handling request.
 	// Proxy: Forwarding request to RealSubject object.
 	// RealSubject: Handling request.
+	// Proxy: Creating a RealSubject object.
+	// Proxy: Forwarding request to RealSubject object.
+	// RealSubject: Handling request.
+	// Lookups: 3, hits: 1, misses: 3, coalesced: 7, evictions: 1
 	/////////////////////////////
 	return 0;
 }
@@ -29,6 +29,402 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Traffic accounting from capture files. A pcap or pcapng file stands in for a live interface, so a monitor
+// can be exercised offline on a recorded capture.
+//
+// CaptureFile maps the file read-only and walks its records in place: packets are handed out as pointers
+// into the mapping, never copied. Both pcap (either byte order, microsecond or nanosecond timestamps) and
+// pcapng (section header, interface description, enhanced and simple packet blocks) are understood;
+// Ethernet (with VLAN tags), Linux cooked and raw IP link types are decoded down to the IPv4/IPv6 addresses
+// and the TCP/UDP ports.
+
+// IPv4 addresses are stored IPv4-mapped so both families share one key type.
+struct IpAddress {
+	std::array<std::uint8_t, 16> bytes{};
+
+	static IpAddress v4(const std::uint8_t* address) {
+		IpAddress ip;
+		ip.bytes[10] = ip.bytes[11] = 0xFF;
+		std::memcpy(&ip.bytes[12], address, 4);
+		return ip;
+	}
+	static IpAddress v6(const std::uint8_t* address) {
+		IpAddress ip;
+		std::memcpy(ip.bytes.data(), address, 16);
+		return ip;
+	}
+	static std::optional<IpAddress> parse(const std::string& text) {
+		std::uint8_t address[16];
+		if (::inet_pton(AF_INET, text.c_str(), address) == 1) return v4(address);
+		if (::inet_pton(AF_INET6, text.c_str(), address) == 1) return v6(address);
+		return std::nullopt;
+	}
+
+	bool isV4() const {
+		static const std::uint8_t prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+		return std::memcmp(bytes.data(), prefix, sizeof(prefix)) == 0;
+	}
+	std::string toString() const {
+		char text[INET6_ADDRSTRLEN];
+		if (isV4()) ::inet_ntop(AF_INET, &bytes[12], text, sizeof(text));
+		else ::inet_ntop(AF_INET6, bytes.data(), text, sizeof(text));
+		return text;
+	}
+	bool operator==(const IpAddress& other) const { return bytes == other.bytes; }
+	bool operator<(const IpAddress& other) const { return bytes < other.bytes; }
+};
+
+struct IpAddressHash {
+	std::size_t operator()(const IpAddress& ip) const {
+		std::uint64_t high, low;
+		std::memcpy(&high, ip.bytes.data(), 8);
+		std::memcpy(&low, ip.bytes.data() + 8, 8);
+		return std::hash<std::uint64_t>{}(high * 0x9E3779B97F4A7C15ULL ^ low);
+	}
+};
+
+// A conversation, the same whichever direction a packet travels: endpoint a is the smaller one.
+struct FlowKey {
+	IpAddress a, b;
+	std::uint16_t portA = 0, portB = 0;
+	std::uint8_t protocol = 0;
+
+	bool operator==(const FlowKey& other) const {
+		return a == other.a && b == other.b && portA == other.portA && portB == other.portB && protocol == other.protocol;
+	}
+};
+
+struct FlowKeyHash {
+	std::size_t operator()(const FlowKey& flow) const {
+		std::size_t hash = IpAddressHash{}(flow.a) * 31 + IpAddressHash{}(flow.b);
+		return hash * 31 + (std::size_t(flow.portA) << 24 | std::size_t(flow.portB) << 8 | flow.protocol);
+	}
+};
+
+class CaptureFile {
+public:
+	struct Packet {
+		const std::uint8_t* data;     // points into the mapping
+		std::uint32_t capturedLength; // bytes present in the file
+		std::uint32_t originalLength; // bytes on the wire
+		std::uint16_t linkType;
+	};
+
+	// Where a walk starts: a record boundary plus the state needed to decode records from there on.
+	struct Cursor {
+		std::size_t offset;
+		bool swapped;                         // file byte order differs from ours
+		std::vector<std::uint16_t> linkTypes; // per pcapng interface; one entry for pcap
+	};
+
+	explicit CaptureFile(const std::string& path) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+		struct stat status;
+		if (::fstat(fd, &status) != 0 || status.st_size < 12) {
+			::close(fd);
+			throw std::runtime_error(path + ": not a capture file");
+		}
+		m_size = static_cast<std::size_t>(status.st_size);
+		void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		int error = errno;
+		::close(fd);
+		if (address == MAP_FAILED) throw std::system_error(error, std::generic_category(), "mmap " + path);
+		m_data = static_cast<const std::uint8_t*>(address);
+		::madvise(address, m_size, MADV_SEQUENTIAL);
+
+		std::uint32_t magic = read32(0, false);
+		if (magic == 0x0A0D0D0A) {
+			m_pcapng = true;
+		} else if (magic == 0xA1B2C3D4 || magic == 0xA1B23C4D || magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1) {
+			if (m_size < 24) {
+				::munmap(address, m_size);
+				throw std::runtime_error(path + ": truncated pcap header");
+			}
+			m_pcapSwapped = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+			m_pcapLinkType = static_cast<std::uint16_t>(read32(20, m_pcapSwapped) & 0xFFFF);
+		} else {
+			::munmap(address, m_size);
+			throw std::runtime_error(path + ": not a pcap or pcapng file");
+		}
+	}
+
+	~CaptureFile() {
+		::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+	}
+	CaptureFile(const CaptureFile&) = delete;
+	CaptureFile& operator=(const CaptureFile&) = delete;
+
+	std::size_t size() const { return m_size; }
+
+	Cursor begin() const {
+		if (m_pcapng) return {0, false, {}};
+		return {24, m_pcapSwapped, {m_pcapLinkType}};
+	}
+
+	// Calls fn(const Packet&) for every packet in the records that start before `stopAt`, and returns the
+	// cursor of the first record it did not read.
+	template <typename Fn>
+	Cursor walk(Cursor cursor, std::size_t stopAt, Fn fn) const {
+		stopAt = std::min(stopAt, m_size);
+		while (cursor.offset < stopAt) {
+			std::size_t at = cursor.offset;
+			if (!m_pcapng) {
+				if (at + 16 > m_size) throw std::runtime_error("truncated pcap record header");
+				std::uint32_t captured = read32(at + 8, cursor.swapped);
+				std::uint32_t original = read32(at + 12, cursor.swapped);
+				if (captured > m_size - at - 16) throw std::runtime_error("truncated pcap record");
+				fn(Packet{m_data + at + 16, captured, original, cursor.linkTypes[0]});
+				cursor.offset = at + 16 + captured;
+				continue;
+			}
+			if (at + 12 > m_size) throw std::runtime_error("truncated pcapng block header");
+			std::uint32_t type = read32(at, cursor.swapped);
+			if (type == 0x0A0D0D0A) { // section header: sets the byte order of everything up to the next one
+				std::uint32_t byteOrder = read32(at + 8, false);
+				if (byteOrder != 0x1A2B3C4D && byteOrder != 0x4D3C2B1A) throw std::runtime_error("bad pcapng byte-order magic");
+				cursor.swapped = byteOrder == 0x4D3C2B1A;
+				cursor.linkTypes.clear();
+			}
+			std::uint32_t length = read32(at + 4, cursor.swapped);
+			if (length < 12 || length % 4 != 0 || length > m_size - at) throw std::runtime_error("truncated pcapng block");
+			if (type == 1) { // interface description
+				cursor.linkTypes.push_back(read16(at + 8, cursor.swapped));
+			} else if (type == 6 && length >= 32) { // enhanced packet
+				std::uint32_t interface = read32(at + 8, cursor.swapped);
+				std::uint32_t captured = read32(at + 20, cursor.swapped);
+				std::uint32_t original = read32(at + 24, cursor.swapped);
+				if (interface >= cursor.linkTypes.size() || captured > length - 32) throw std::runtime_error("bad pcapng enhanced packet block");
+				fn(Packet{m_data + at + 28, captured, original, cursor.linkTypes[interface]});
+			} else if (type == 3 && length >= 16) { // simple packet: always interface 0
+				std::uint32_t original = read32(at + 8, cursor.swapped);
+				if (cursor.linkTypes.empty()) throw std::runtime_error("pcapng packet before any interface");
+				fn(Packet{m_data + at + 12, std::min(original, length - 16), original, cursor.linkTypes[0]});
+			}
+			cursor.offset = at + length;
+		}
+		return cursor;
+	}
+
+	// Cursors at record boundaries about chunkBytes apart, so chunks can be walked independently. Only the
+	// record headers are read.
+	std::vector<Cursor> split(std::size_t chunkBytes) const {
+		std::vector<Cursor> cursors{begin()};
+		for (;;) {
+			Cursor next = walk(cursors.back(), cursors.back().offset + chunkBytes, [](const Packet&) {});
+			if (next.offset >= m_size) return cursors;
+			cursors.push_back(std::move(next));
+		}
+	}
+
+	// Extracts the flow of an IPv4/IPv6 packet; false for anything else or a packet cut short.
+	static bool decode(const Packet& packet, FlowKey& flow) {
+		const std::uint8_t* p = packet.data;
+		std::size_t n = packet.capturedLength;
+		std::uint16_t etherType;
+		switch (packet.linkType) {
+		case 1: // Ethernet
+			if (n < 14) return false;
+			etherType = be16(p + 12);
+			p += 14, n -= 14;
+			while (etherType == 0x8100 || etherType == 0x88A8) { // VLAN tags
+				if (n < 4) return false;
+				etherType = be16(p + 2);
+				p += 4, n -= 4;
+			}
+			break;
+		case 113: // Linux cooked capture
+			if (n < 16) return false;
+			etherType = be16(p + 14);
+			p += 16, n -= 16;
+			break;
+		case 12: case 101: // raw IP
+			if (n < 1) return false;
+			etherType = (p[0] >> 4) == 6 ? 0x86DD : 0x0800;
+			break;
+		default:
+			return false;
+		}
+
+		IpAddress source, destination;
+		std::size_t transport;
+		if (etherType == 0x0800) {
+			if (n < 20 || (p[0] >> 4) != 4) return false;
+			transport = std::size_t(p[0] & 0x0F) * 4;
+			if (transport < 20) return false; // IHL below 5: not a valid header
+			flow.protocol = p[9];
+			source = IpAddress::v4(p + 12);
+			destination = IpAddress::v4(p + 16);
+			if ((be16(p + 6) & 0x1FFF) != 0) transport = n; // later fragments carry no ports
+		} else if (etherType == 0x86DD) {
+			if (n < 40) return false;
+			transport = 40;
+			flow.protocol = p[6];
+			source = IpAddress::v6(p + 8);
+			destination = IpAddress::v6(p + 24);
+			for (bool more = true; more && transport + 8 <= n;) { // extension headers up to the transport header
+				const std::uint8_t* header = p + transport;
+				switch (flow.protocol) {
+				case 0: case 43: case 60: case 135: case 139: case 140: // hop-by-hop, routing, destination, mobility, HIP, shim6
+					flow.protocol = header[0];
+					transport += (std::size_t(header[1]) + 1) * 8;
+					break;
+				case 44: // fragment: only the first one carries the ports
+					flow.protocol = header[0];
+					transport = (be16(header + 2) & 0xFFF8) != 0 ? n : transport + 8;
+					break;
+				case 51: // authentication header, sized in 4-byte words
+					flow.protocol = header[0];
+					transport += (std::size_t(header[1]) + 2) * 4;
+					break;
+				default: // transport protocol, ESP or no next header
+					more = false;
+				}
+			}
+		} else {
+			return false;
+		}
+		std::uint16_t sourcePort = 0, destinationPort = 0;
+		if ((flow.protocol == 6 || flow.protocol == 17) && transport + 4 <= n) {
+			sourcePort = be16(p + transport);
+			destinationPort = be16(p + transport + 2);
+		}
+		bool ordered = source < destination || (source == destination && sourcePort <= destinationPort);
+		flow.a = ordered ? source : destination;
+		flow.b = ordered ? destination : source;
+		flow.portA = ordered ? sourcePort : destinationPort;
+		flow.portB = ordered ? destinationPort : sourcePort;
+		return true;
+	}
+
+private:
+	static std::uint16_t be16(const std::uint8_t* p) { return static_cast<std::uint16_t>(p[0] << 8 | p[1]); }
+
+	std::uint32_t read32(std::size_t at, bool swapped) const {
+		std::uint32_t value;
+		std::memcpy(&value, m_data + at, sizeof(value));
+		return swapped ? __builtin_bswap32(value) : value;
+	}
+	std::uint16_t read16(std::size_t at, bool swapped) const {
+		std::uint16_t value;
+		std::memcpy(&value, m_data + at, sizeof(value));
+		return swapped ? __builtin_bswap16(value) : value;
+	}
+
+	const std::uint8_t* m_data = nullptr;
+	std::size_t m_size = 0;
+	bool m_pcapng = false;
+	bool m_pcapSwapped = false;
+	std::uint16_t m_pcapLinkType = 0;
+};
+
+struct TrafficCounters {
+	std::uint64_t bytes = 0;   // sent and received, as seen on the wire
+	std::uint64_t packets = 0;
+	std::uint64_t flows = 0;   // distinct conversations the host took part in
+};
+
+struct TrafficSummary {
+	std::unordered_map<IpAddress, TrafficCounters, IpAddressHash> hosts;
+	std::uint64_t packets = 0;
+	std::uint64_t nonIpPackets = 0;
+
+	std::vector<std::pair<IpAddress, TrafficCounters>> topTalkers(std::size_t count) const { // by bytes
+		std::vector<std::pair<IpAddress, TrafficCounters>> talkers(hosts.begin(), hosts.end());
+		count = std::min(count, talkers.size());
+		std::partial_sort(talkers.begin(), talkers.begin() + count, talkers.end(),
+						  [](const auto& x, const auto& y) { return x.second.bytes > y.second.bytes; });
+		talkers.resize(count);
+		return talkers;
+	}
+};
+
+// One pass over a capture for every host in it. The file is split into chunks at record boundaries and
+// `threads` workers claim chunks through an atomic counter. Each worker aggregates into its own tables, so
+// the hot loop shares nothing and takes no lock; the tables are merged once the workers are done.
+TrafficSummary analyzeCapture(const std::string& path, unsigned threads = std::thread::hardware_concurrency()) {
+	struct alignas(64) Partial { // one per worker, padded so workers never share a cache line
+		std::unordered_map<IpAddress, TrafficCounters, IpAddressHash> hosts;
+		std::unordered_set<FlowKey, FlowKeyHash> flows;
+		std::uint64_t packets = 0;
+		std::uint64_t nonIpPackets = 0;
+	};
+	CaptureFile capture(path);
+	threads = std::max(threads, 1u);
+	std::vector<CaptureFile::Cursor> chunks = capture.split(std::max<std::size_t>(capture.size() / (threads * 8), 1 << 20));
+	std::vector<Partial> partials(threads);
+	std::atomic<std::size_t> nextChunk{0};
+	auto work = [&](Partial& partial) {
+		for (std::size_t i; (i = nextChunk.fetch_add(1)) < chunks.size();) {
+			std::size_t end = i + 1 < chunks.size() ? chunks[i + 1].offset : capture.size();
+			capture.walk(chunks[i], end, [&](const CaptureFile::Packet& packet) {
+				++partial.packets;
+				FlowKey flow;
+				if (!CaptureFile::decode(packet, flow)) {
+					++partial.nonIpPackets;
+					return;
+				}
+				for (const IpAddress* host : {&flow.a, &flow.b}) {
+					TrafficCounters& counters = partial.hosts[*host];
+					counters.bytes += packet.originalLength;
+					++counters.packets;
+					if (flow.a == flow.b) break; // talking to itself: count once
+				}
+				partial.flows.insert(flow);
+			});
+		}
+	};
+	std::vector<std::thread> workers;
+	for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work, std::ref(partials[t]));
+	work(partials[0]);
+	for (auto& worker : workers) worker.join();
+
+	TrafficSummary summary;
+	std::unordered_set<FlowKey, FlowKeyHash> flows;
+	for (Partial& partial : partials) {
+		summary.packets += partial.packets;
+		summary.nonIpPackets += partial.nonIpPackets;
+		for (const auto& [host, counters] : partial.hosts) {
+			TrafficCounters& total = summary.hosts[host];
+			total.bytes += counters.bytes;
+			total.packets += counters.packets;
+		}
+		flows.merge(partial.flows);
+	}
+	for (const FlowKey& flow : flows) {
+		++summary.hosts[flow.a].flows;
+		if (!(flow.a == flow.b)) ++summary.hosts[flow.b].flows;
+	}
+	return summary;
+}
 
 // Subject interface
 class NetworkMonitor {
@@ -40,45 +436,441 @@ public:
 // RealSubject class
 class RealNetworkMonitor : public NetworkMonitor {
 public:
-	RealNetworkMonitor(const std::string& ipAddress) : m_ipAddress(ipAddress) {}
+	RealNetworkMonitor(const std::string& ipAddress, std::chrono::milliseconds latency = std::chrono::milliseconds(0))
+		: m_ipAddress(ipAddress), m_latency(latency) {}
+
+	// Accounts the traffic of `ipAddress` recorded in a pcap/pcapng capture.
+	RealNetworkMonitor(const std::string& ipAddress, const std::string& capturePath)
+		: m_ipAddress(ipAddress), m_latency(0), m_capturePath(capturePath) {}
 
 	void monitor() const override {
-		std::cout << "Monitoring network traffic on IP address " << m_ipAddress << std::endl;
+		std::cout << probe() << std::endl;
 	}
 
+	// One monitoring pass, returned as a report line instead of printed, so passes can run concurrently.
+	// `latency` simulates how long the target takes to answer; a capture is analysed on up to `threads` threads.
+	std::string probe(unsigned threads = std::thread::hardware_concurrency()) const {
+		if (!m_capturePath.empty()) return report(analyzeCapture(m_capturePath, threads));
+		std::this_thread::sleep_for(m_latency);
+		return "Monitoring network traffic on IP address " + m_ipAddress;
+	}
+
+	// This target's line out of a capture analysed once for every host in it.
+	std::string report(const TrafficSummary& summary) const {
+		std::optional<IpAddress> ip = IpAddress::parse(m_ipAddress);
+		TrafficCounters counters;
+		if (ip) {
+			auto found = summary.hosts.find(*ip);
+			if (found != summary.hosts.end()) counters = found->second;
+		}
+		return "IP address " + m_ipAddress + ": " + std::to_string(counters.packets) + " packets, " + std::to_string(counters.bytes)
+			+ " bytes, " + std::to_string(counters.flows) + " flows";
+	}
+
+	const std::string& ipAddress() const { return m_ipAddress; }
+	const std::string& capturePath() const { return m_capturePath; }
+
 private:
 	std::string m_ipAddress;
+	std::chrono::milliseconds m_latency;
+	std::string m_capturePath; // empty: simulated target
+};
+
+// Fixed set of threads draining a task queue: at most `threads` probes run at once. A thread stuck in a task
+// that will not return in time can be abandoned: a fresh thread takes its place in the pool, and the stuck one
+// is detached and exits as soon as its task returns, without taking more work. Tasks must therefore own
+// everything they touch. The destructor joins only the threads still in the pool.
+class WorkerPool {
+public:
+	explicit WorkerPool(std::size_t threads) : m_state(std::make_shared<State>()) {
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		for (std::size_t i = 0; i < threads; ++i) {
+			start();
+		}
+	}
+
+	~WorkerPool() {
+		std::vector<std::thread> threads;
+		{
+			std::lock_guard<std::mutex> lock(m_state->mutex);
+			m_state->stopping = true;
+			threads.swap(m_threads);
+		}
+		m_state->changed.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void submit(std::function<void()> task) {
+		{
+			std::lock_guard<std::mutex> lock(m_state->mutex);
+			m_state->tasks.push_back(std::move(task));
+		}
+		m_state->changed.notify_one();
+	}
+
+	// Replaces the pool thread `id` (the one running a task that overran) with a new one.
+	void abandon(std::thread::id id) {
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		auto found = std::find_if(m_threads.begin(), m_threads.end(), [&](const std::thread& thread) { return thread.get_id() == id; });
+		if (found == m_threads.end()) return; // already abandoned
+		m_state->abandoned.insert(id);
+		found->detach();
+		m_threads.erase(found);
+		start();
+	}
+
+private:
+	struct State { // outlives the pool while an abandoned thread is still running
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<std::function<void()>> tasks;
+		std::unordered_set<std::thread::id> abandoned;
+		bool stopping = false;
+	};
+
+	void start() { // called with the state locked
+		m_threads.emplace_back([state = m_state] { run(*state); });
+	}
+
+	static void run(State& state) {
+		for (;;) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(state.mutex);
+				if (state.abandoned.erase(std::this_thread::get_id()) != 0) return;
+				state.changed.wait(lock, [&] { return state.stopping || !state.tasks.empty(); });
+				if (state.tasks.empty()) return;
+				task = std::move(state.tasks.front());
+				state.tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::shared_ptr<State> m_state;
+	std::vector<std::thread> m_threads; // guarded by m_state->mutex
+};
+
+// Outcome of one monitoring pass over every target, in the order the targets were given.
+struct MonitorReport {
+	struct Target {
+		std::string ipAddress;
+		std::string line;      // the target's report, empty when it timed out or failed
+		bool timedOut;
+		std::chrono::milliseconds elapsed;
+		std::string error;     // why the probe failed (an unreadable or malformed capture), empty otherwise
+	};
+	std::vector<Target> targets;
+	std::chrono::milliseconds elapsed;
+	std::vector<std::pair<std::string, TrafficCounters>> topTalkers; // capture monitoring only
 };
 
 // Proxy class
+// With workers > 0, monitor() fans the targets out on a bounded worker pool and merges their answers into
+// one report, so a pass takes about as long as the slowest target instead of the sum of all of them. A
+// target that has not answered `timeout` after its probe started is reported as timed out; targets still
+// queued behind busy workers are not charged for the wait. A blocking probe cannot be interrupted, so the
+// stuck worker is abandoned to finish in the background (its late answer is dropped) and a fresh one
+// replaces it, which keeps later passes and the destructor from waiting on it.
+// With workers == 0 the targets are probed one after the other on the calling thread.
+// When every target monitors the same capture file, the capture is read once for all of them.
+// A probe that throws fails only its own target: the exception's message is reported as that target's error,
+// whichever path ran it.
 class NetworkMonitorProxy : public NetworkMonitor {
 public:
-	NetworkMonitorProxy(const std::vector<std::string>& ipAddresses) {
+	NetworkMonitorProxy(const std::vector<std::string>& ipAddresses, std::size_t workers = 0,
+						std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+		: m_timeout(timeout) {
+		m_realMonitors.reserve(ipAddresses.size()); // every monitor lives in one block, no per-target new/delete
 		for (const auto& ipAddress : ipAddresses) {
-			m_realMonitors.push_back(new RealNetworkMonitor(ipAddress));
+			m_realMonitors.emplace_back(ipAddress);
 		}
+		if (workers > 0) m_pool = std::make_unique<WorkerPool>(workers);
+		m_probeThreads = std::max(1u, std::thread::hardware_concurrency() / static_cast<unsigned>(std::max<std::size_t>(workers, 1)));
 	}
 
-	~NetworkMonitorProxy() {
-		for (const auto& monitor : m_realMonitors) {
-			delete monitor;
-		}
+	NetworkMonitorProxy(std::vector<RealNetworkMonitor> realMonitors, std::size_t workers = 0,
+						std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+		: m_realMonitors(std::move(realMonitors)), m_timeout(timeout) {
+		if (workers > 0) m_pool = std::make_unique<WorkerPool>(workers);
+		m_probeThreads = std::max(1u, std::thread::hardware_concurrency() / static_cast<unsigned>(std::max<std::size_t>(workers, 1)));
 	}
 
 	void monitor() const override {
+		MonitorReport report = collect();
 		std::cout << "Monitoring network traffic on all IP addresses:" << std::endl;
-		for (const auto& monitor : m_realMonitors) {
-			monitor->monitor();
+		for (const auto& target : report.targets) {
+			if (target.timedOut) {
+				std::cout << "No answer from IP address " << target.ipAddress << " within " << m_timeout.count() << " ms" << std::endl;
+			} else if (!target.error.empty()) {
+				std::cout << "Probe of IP address " << target.ipAddress << " failed: " << target.error << std::endl;
+			} else {
+				std::cout << target.line << std::endl;
+			}
+		}
+		if (!report.topTalkers.empty()) {
+			std::cout << "Top talkers:" << std::endl;
+			for (const auto& [ip, counters] : report.topTalkers) {
+				std::cout << "  " << ip << ": " << counters.bytes << " bytes in " << counters.packets << " packets" << std::endl;
+			}
+		}
+	}
+
+	MonitorReport collect() const {
+		using Clock = std::chrono::steady_clock;
+		auto start = Clock::now();
+		auto since = [](Clock::time_point from) { return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - from); };
+		MonitorReport report;
+		if (sharedCapture()) {
+			TrafficSummary summary;
+			try {
+				summary = analyzeCapture(m_realMonitors[0].capturePath()); // one pass for every target
+			} catch (const std::exception& e) {
+				for (const auto& monitor : m_realMonitors) {
+					report.targets.push_back({monitor.ipAddress(), std::string(), false, std::chrono::milliseconds(0), e.what()});
+				}
+				report.elapsed = since(start);
+				return report;
+			}
+			for (const auto& monitor : m_realMonitors) {
+				report.targets.push_back({monitor.ipAddress(), monitor.report(summary), false, std::chrono::milliseconds(0), std::string()});
+			}
+			for (const auto& [ip, counters] : summary.topTalkers(5)) {
+				report.topTalkers.emplace_back(ip.toString(), counters);
+			}
+			report.elapsed = since(start);
+			return report;
+		}
+		if (!m_pool) {
+			for (const auto& monitor : m_realMonitors) {
+				auto began = Clock::now();
+				std::string line, error;
+				try {
+					line = monitor.probe(m_probeThreads);
+				} catch (const std::exception& e) {
+					error = e.what();
+				}
+				report.targets.push_back({monitor.ipAddress(), line, false, since(began), error});
+			}
+			report.elapsed = since(start);
+			return report;
+		}
+
+		// Shared with the tasks: a target that times out still writes here after collect() has returned.
+		struct Probe {
+			std::optional<Clock::time_point> started; // set by the worker that picks the probe up
+			std::thread::id worker;
+			std::optional<std::pair<std::string, std::chrono::milliseconds>> answer;
+			std::string error;                        // set with an empty answer line when the probe threw
+			bool timedOut = false;
+		};
+		struct Pass {
+			std::mutex mutex;
+			std::condition_variable changed;
+			std::vector<Probe> probes;
+		};
+		auto pass = std::make_shared<Pass>();
+		pass->probes.resize(m_realMonitors.size());
+		for (std::size_t i = 0; i < m_realMonitors.size(); ++i) {
+			m_pool->submit([pass, monitor = m_realMonitors[i], i, since, threads = m_probeThreads] { // a copy: an abandoned probe may outlive the proxy
+				auto began = Clock::now();
+				{
+					std::lock_guard<std::mutex> lock(pass->mutex);
+					pass->probes[i].started = began;
+					pass->probes[i].worker = std::this_thread::get_id();
+				}
+				pass->changed.notify_all(); // its deadline starts now
+				std::string line, error;
+				try { // an escaping exception would terminate the worker thread, and with it the process
+					line = monitor.probe(threads);
+				} catch (const std::exception& e) {
+					error = e.what();
+				}
+				{
+					std::lock_guard<std::mutex> lock(pass->mutex);
+					pass->probes[i].answer.emplace(std::move(line), since(began));
+					pass->probes[i].error = std::move(error);
+				}
+				pass->changed.notify_all();
+			});
+		}
+		std::unique_lock<std::mutex> lock(pass->mutex);
+		for (;;) { // until every probe has answered or overrun its own deadline
+			bool waiting = false;
+			Clock::time_point next = Clock::time_point::max(); // earliest deadline still running
+			for (Probe& probe : pass->probes) {
+				if (probe.answer || probe.timedOut) continue;
+				if (probe.started && Clock::now() >= *probe.started + m_timeout) {
+					probe.timedOut = true;
+					m_pool->abandon(probe.worker);
+					continue;
+				}
+				waiting = true;
+				if (probe.started) next = std::min(next, *probe.started + m_timeout); // still queued: no deadline yet
+			}
+			if (!waiting) break;
+			if (next == Clock::time_point::max()) pass->changed.wait(lock);
+			else pass->changed.wait_until(lock, next);
 		}
+		for (std::size_t i = 0; i < m_realMonitors.size(); ++i) {
+			const Probe& probe = pass->probes[i];
+			report.targets.push_back({m_realMonitors[i].ipAddress(), probe.timedOut ? std::string() : probe.answer->first, probe.timedOut,
+									  probe.timedOut ? m_timeout : probe.answer->second, probe.timedOut ? std::string() : probe.error});
+		}
+		report.elapsed = since(start);
+		return report;
 	}
 
 private:
-	std::vector<RealNetworkMonitor*> m_realMonitors;
+	bool sharedCapture() const {
+		if (m_realMonitors.empty() || m_realMonitors[0].capturePath().empty()) return false;
+		for (const auto& monitor : m_realMonitors) {
+			if (monitor.capturePath() != m_realMonitors[0].capturePath()) return false;
+		}
+		return true;
+	}
+
+	std::vector<RealNetworkMonitor> m_realMonitors;
+	std::chrono::milliseconds m_timeout;
+	unsigned m_probeThreads; // capture analysis threads per probe: the cores split between the pool's workers
+	std::unique_ptr<WorkerPool> m_pool; // declared last: joined before the rest of the proxy goes away
 };
 
+// Writes `packets` Ethernet/IPv4 TCP and UDP packets between 20 clients and 3 servers, truncated to their
+// headers as a capture with a small snap length would be. Client 10.0.0.1 is the heaviest talker.
+void writeSyntheticCapture(const std::string& path, bool pcapng, std::size_t packets) {
+	std::ofstream out(path, std::ios::binary);
+	auto put32 = [&](std::uint32_t value) { out.write(reinterpret_cast<const char*>(&value), 4); };
+	auto put16 = [&](std::uint16_t value) { out.write(reinterpret_cast<const char*>(&value), 2); };
+	const std::uint32_t snapLength = 54;
+	if (pcapng) {
+		put32(0x0A0D0D0A), put32(28), put32(0x1A2B3C4D), put16(1), put16(0), put32(0xFFFFFFFF), put32(0xFFFFFFFF), put32(28);
+		put32(1), put32(20), put16(1), put16(0), put32(snapLength), put32(20);
+	} else {
+		put32(0xA1B2C3D4), put16(2), put16(4), put32(0), put32(0), put32(snapLength), put32(1);
+	}
+	std::uint32_t seed = 12345;
+	auto random = [&](std::uint32_t range) { seed = seed * 1103515245 + 12345; return (seed >> 8) % range; };
+	std::uint8_t frame[snapLength] = {};
+	for (std::size_t i = 0; i < packets; ++i) {
+		std::uint8_t client = static_cast<std::uint8_t>(random(4) == 0 ? 1 : 1 + random(20));
+		std::uint8_t server = static_cast<std::uint8_t>(1 + random(3));
+		bool upstream = random(2) == 0;
+		bool tcp = random(4) != 0;
+		std::uint16_t clientPort = static_cast<std::uint16_t>(40000 + random(8));
+		std::uint16_t serverPort = tcp ? 443 : 53;
+		std::uint32_t original = tcp ? 60 + random(1440) : 80 + random(100);
+		std::uint8_t clientIp[4] = {10, 0, 0, client}, serverIp[4] = {192, 168, 1, server};
+		frame[12] = 0x08, frame[13] = 0x00;                 // IPv4
+		std::uint8_t* ip = frame + 14;
+		ip[0] = 0x45;
+		ip[9] = tcp ? 6 : 17;
+		std::memcpy(ip + 12, upstream ? clientIp : serverIp, 4);
+		std::memcpy(ip + 16, upstream ? serverIp : clientIp, 4);
+		std::uint16_t from = upstream ? clientPort : serverPort, to = upstream ? serverPort : clientPort;
+		ip[20] = static_cast<std::uint8_t>(from >> 8), ip[21] = static_cast<std::uint8_t>(from);
+		ip[22] = static_cast<std::uint8_t>(to >> 8), ip[23] = static_cast<std::uint8_t>(to);
+		if (pcapng) {
+			put32(6), put32(32 + 56), put32(0), put32(0), put32(static_cast<std::uint32_t>(i)), put32(snapLength), put32(original);
+			out.write(reinterpret_cast<const char*>(frame), snapLength);
+			put16(0);                                          // pad the packet data to 4 bytes
+			put32(32 + 56);
+		} else {
+			put32(static_cast<std::uint32_t>(i / 1000)), put32(static_cast<std::uint32_t>(i % 1000)), put32(snapLength), put32(original);
+			out.write(reinterpret_cast<const char*>(frame), snapLength);
+		}
+	}
+}
+
 int main() {
 	std::vector<std::string> ipAddresses = {"192.168.1.1", "192.168.1.2", "192.168.1.3"};
 	NetworkMonitorProxy proxy(ipAddresses);
 	proxy.monitor();
+
+	// Simulated slow targets: twenty answer in 100 ms, one in 400 ms and one hangs for 1.5 s.
+	std::vector<RealNetworkMonitor> targets;
+	for (int i = 1; i <= 20; ++i) {
+		targets.emplace_back("10.0.0." + std::to_string(i), std::chrono::milliseconds(100));
+	}
+	targets.emplace_back("10.0.0.21", std::chrono::milliseconds(400));
+	targets.emplace_back("10.0.0.22", std::chrono::milliseconds(1500));
+	for (std::size_t workers : {std::size_t(0), std::size_t(32)}) {
+		NetworkMonitorProxy fleet(targets, workers, std::chrono::milliseconds(600));
+		MonitorReport report = fleet.collect();
+		std::size_t timedOut = 0;
+		for (const auto& target : report.targets) timedOut += target.timedOut;
+		std::cout << (workers ? "Fan-out on 32 workers: " : "One target at a time: ") << report.targets.size() << " targets in "
+				  << report.elapsed.count() << " ms, " << timedOut << " timed out" << std::endl;
+	}
+
+	// A small pool: 2 workers, a target that hangs and six that answer in 250 ms. Each target's 600 ms runs from
+	// when its probe starts, and the worker stuck on the hung target is replaced, so queued targets still get
+	// their full timeout and the second pass is not starved by the first one's hung probe.
+	std::vector<RealNetworkMonitor> queued{RealNetworkMonitor("10.0.1.1", std::chrono::milliseconds(1500))};
+	for (int i = 2; i <= 7; ++i) {
+		queued.emplace_back("10.0.1." + std::to_string(i), std::chrono::milliseconds(250));
+	}
+	NetworkMonitorProxy small(queued, 2, std::chrono::milliseconds(600));
+	for (int pass = 1; pass <= 2; ++pass) {
+		MonitorReport report = small.collect();
+		std::size_t timedOut = 0;
+		for (const auto& target : report.targets) timedOut += target.timedOut;
+		std::cout << "2 workers, pass " << pass << ": " << report.targets.size() << " targets in " << report.elapsed.count() << " ms, "
+				  << timedOut << " timed out" << std::endl;
+	}
+
+	// Traffic accounting from captures: the proxy reads each file once for all of its targets.
+	writeSyntheticCapture("capture.pcap", false, 500000);
+	writeSyntheticCapture("capture.pcapng", true, 500000);
+	for (const char* capture : {"capture.pcap", "capture.pcapng"}) {
+		std::vector<RealNetworkMonitor> hosts;
+		for (const char* ip : {"10.0.0.1", "10.0.0.2", "192.168.1.1"}) {
+			hosts.emplace_back(ip, capture);
+		}
+		NetworkMonitorProxy captureProxy(hosts);
+		auto start = std::chrono::steady_clock::now();
+		captureProxy.monitor();
+		std::cout << capture << " analysed in "
+				  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+		std::remove(capture);
+	}
+
+	// Targets on different captures, one of them missing: the broken target is reported, the others still answer,
+	// both on the calling thread and on the pool.
+	writeSyntheticCapture("small.pcap", false, 1000);
+	std::vector<RealNetworkMonitor> mixed{RealNetworkMonitor("10.0.0.1", "small.pcap"), RealNetworkMonitor("10.0.0.2", "missing.pcap")};
+	for (std::size_t workers : {std::size_t(0), std::size_t(2)}) {
+		NetworkMonitorProxy(mixed, workers).monitor();
+	}
+	std::remove("small.pcap");
+
+	//////////// output //////////
+	// Monitoring network traffic on all IP addresses:
+	// Monitoring network traffic on IP address 192.168.1.1
+	// Monitoring network traffic on IP address 192.168.1.2
+	// Monitoring network traffic on IP address 192.168.1.3
+	// One target at a time: 22 targets in 3907 ms, 0 timed out
+	// Fan-out on 32 workers: 22 targets in 600 ms, 1 timed out
+	// 2 workers, pass 1: 7 targets in 1100 ms, 1 timed out
+	// 2 workers, pass 2: 7 targets in 1100 ms, 1 timed out
+	// Monitoring network traffic on all IP addresses:
+	// IP address 10.0.0.1: 170600 packets, 107697349 bytes, 48 flows
+	// IP address 10.0.0.2: 13728 packets, 9051277 bytes, 42 flows
+	// IP address 192.168.1.1: 166806 packets, 108696117 bytes, 280 flows
+	// Top talkers:
+	//   192.168.1.3: 108753235 bytes in 166571 packets
+	//   192.168.1.2: 108727499 bytes in 166623 packets
+	//   192.168.1.1: 108696117 bytes in 166806 packets
+	//   10.0.0.1: 107697349 bytes in 170600 packets
+	//   10.0.0.3: 13872793 bytes in 20349 packets
+	// capture.pcap analysed in 45 ms
+	// ... the same report again for capture.pcapng
+	// Monitoring network traffic on all IP addresses:
+	// IP address 10.0.0.1: 339 packets, 215271 bytes, 47 flows
+	// Probe of IP address 10.0.0.2 failed: open missing.pcap: No such file or directory
+	// ... the same two lines again from the 2-worker pool
+	/////////////////////////////
 	return 0;
 }
@@ -1,5 +1,12 @@
 #include <iostream>
 #include <stdarg.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
 
 int AddNumbers(int n, ...)
 {
@@ -27,6 +34,162 @@ void error_log(const char * level, const char* format, ... )
 	fprintf( stderr, "\n" );
 }
 
+//-------------------- Type-safe, level-filtered log<Level> --------------------//
+// Variadic template replacement for error_log: the format string is checked against the argument types at
+// compile time (a mismatch is a compile error instead of undefined behaviour), calls below minLevel compile
+// to nothing, and the enabled path formats into a stack buffer without touching the heap.
+
+enum class Level { Debug, Info, Warning, Error };
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 1 // Info; build with -DLOG_MIN_LEVEL=0 to keep Debug calls
+#endif
+constexpr Level minLevel = static_cast<Level>(LOG_MIN_LEVEL);
+
+constexpr const char* levelName(Level level)
+{
+	switch (level) {
+	case Level::Debug: return "DEBUG";
+	case Level::Info: return "INFO";
+	case Level::Warning: return "WARNING";
+	default: return "ERROR";
+	}
+}
+
+enum class ArgKind { Integer, Character, Floating, String, Pointer, Unsupported };
+
+struct ArgInfo {
+	ArgKind kind;
+	std::size_t size;
+};
+
+template <typename T>
+consteval ArgInfo argInfo()
+{
+	using U = std::decay_t<T>; // string literals arrive as char arrays
+	if constexpr (std::is_same_v<U, char>) return {ArgKind::Character, sizeof(U)};
+	else if constexpr (std::is_integral_v<U>) return {ArgKind::Integer, sizeof(U)};
+	else if constexpr (std::is_floating_point_v<U>) return {ArgKind::Floating, sizeof(U)};
+	else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> || std::is_same_v<U, std::string>) return {ArgKind::String, sizeof(U)};
+	else if constexpr (std::is_pointer_v<U>) return {ArgKind::Pointer, sizeof(U)};
+	else return {ArgKind::Unsupported, sizeof(U)};
+}
+
+consteval bool integerLengthMatches(std::string_view modifier, std::size_t size)
+{
+	if (modifier.empty() || modifier == "h" || modifier == "hh") return size <= sizeof(int);
+	if (modifier == "l") return size == sizeof(long);
+	if (modifier == "ll") return size == sizeof(long long);
+	if (modifier == "z") return size == sizeof(std::size_t);
+	if (modifier == "j") return size == sizeof(std::intmax_t);
+	if (modifier == "t") return size == sizeof(std::ptrdiff_t);
+	return false;
+}
+
+// Walks the printf conversions and checks each one against the next argument.
+template <typename... Args>
+consteval bool formatMatches(std::string_view format)
+{
+	constexpr ArgInfo args[] = {argInfo<Args>()..., ArgInfo{ArgKind::Unsupported, 0}}; // sentinel keeps the array non-empty
+	constexpr std::size_t count = sizeof...(Args);
+	std::size_t next = 0;
+	for (std::size_t i = 0; i < format.size(); ++i) {
+		if (format[i] != '%') continue;
+		if (++i == format.size()) return false;
+		if (format[i] == '%') continue;
+		while (i < format.size() && std::string_view("-+ #0").find(format[i]) != std::string_view::npos) ++i; // flags
+		while (i < format.size() && format[i] >= '0' && format[i] <= '9') ++i; // width ('*' is not supported)
+		if (i < format.size() && format[i] == '.') {
+			++i;
+			while (i < format.size() && format[i] >= '0' && format[i] <= '9') ++i; // precision
+		}
+		std::size_t modifierStart = i;
+		while (i < format.size() && std::string_view("hljztL").find(format[i]) != std::string_view::npos) ++i;
+		std::string_view modifier = format.substr(modifierStart, i - modifierStart);
+		if (i == format.size() || next == count) return false; // truncated conversion or too few arguments
+		ArgInfo arg = args[next++];
+		switch (format[i]) {
+		case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+			if ((arg.kind != ArgKind::Integer && arg.kind != ArgKind::Character) || !integerLengthMatches(modifier, arg.size)) return false;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			if (arg.kind != ArgKind::Floating) return false;
+			if (modifier == "L" ? arg.size != sizeof(long double) : (arg.size > sizeof(double) || (!modifier.empty() && modifier != "l"))) return false;
+			break;
+		case 'c':
+			if ((arg.kind != ArgKind::Character && arg.kind != ArgKind::Integer) || !modifier.empty() || arg.size > sizeof(int)) return false;
+			break;
+		case 's':
+			if (arg.kind != ArgKind::String || !modifier.empty()) return false;
+			break;
+		case 'p':
+			if ((arg.kind != ArgKind::Pointer && arg.kind != ArgKind::String) || !modifier.empty()) return false;
+			break;
+		default:
+			return false;
+		}
+	}
+	return next == count; // too many arguments is an error as well
+}
+
+// Only constructible from a string literal that matches Args; evaluated by the compiler (consteval).
+template <typename... Args>
+class FormatString {
+public:
+	template <std::size_t N>
+	consteval FormatString(const char (&format)[N]) : text(format)
+	{
+		if (!formatMatches<Args...>(std::string_view(format, N - 1))) {
+			throw "log: format string does not match the argument types"; // not a constant expression -> compile error
+		}
+	}
+
+	const char* text;
+};
+
+// Where formatted lines go. The text is only valid for the duration of the call (it lives on the caller's stack).
+using LogSink = void (*)(Level level, const char* text, std::size_t length);
+
+void stderrSink(Level, const char* text, std::size_t length)
+{
+	fwrite(text, 1, length, stderr);
+	fputc('\n', stderr);
+}
+
+std::atomic<LogSink> logSink{stderrSink};
+
+void setLogSink(LogSink sink)
+{
+	logSink.store(sink, std::memory_order_release);
+}
+
+template <typename T>
+auto printfArg(const T& value)
+{
+	if constexpr (std::is_same_v<T, std::string>) return value.c_str();
+	else return value; // arrays decay to pointers here
+}
+
+// Calling log<Level> directly still evaluates the arguments of a disabled call; go through LOG below when
+// they have side effects or cost something to compute.
+template <Level level, typename... Args>
+void log(FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+	if constexpr (level >= minLevel) {
+		char buffer[512]; // longer messages are truncated
+		int prefix = snprintf(buffer, sizeof(buffer), "[%s]: ", levelName(level));
+		int body = snprintf(buffer + prefix, sizeof(buffer) - prefix, format.text, printfArg(args)...);
+		std::size_t length = std::min(static_cast<std::size_t>(prefix + (body > 0 ? body : 0)), sizeof(buffer) - 1);
+		logSink.load(std::memory_order_acquire)(level, buffer, length);
+	}
+}
+
+// LOG(Debug, "x=%d", expensive()) puts the level test at the call site, so a call below minLevel is still
+// type-checked but none of its arguments are evaluated.
+#define LOG(level, format, ...) \
+	do { \
+		if constexpr (Level::level >= minLevel) log<Level::level>(format, ##__VA_ARGS__); \
+	} while (0)
 
 
 int main(int argc, char const *argv[])
@@ -45,6 +208,15 @@ int main(int argc, char const *argv[])
 	error_log("WARNING", "Path (%s) not found at %s", "c:\\user\\Document", "2022-03-11 09:38"); // WARNING]: Path (c:\user\Document) not found at 2022-03-11 09:38
 	error_log("ERROR", "An error has occured %d times due to %s", 3, "Exception"); // [ERROR]: An error has occured 3 times due to Exception
 
+	//-------------------- Variadic templates log<Level> --------------------//
+	log<Level::Warning>("Path (%s) not found at %s", "c:\\user\\Document", "2022-03-11 09:38"); // [WARNING]: Path (c:\user\Document) not found at 2022-03-11 09:38
+	log<Level::Error>("An error has occured %d times due to %s", 3, std::string("Exception")); // [ERROR]: An error has occured 3 times due to Exception
+	log<Level::Debug>("Cache hit ratio %f", 0.93); // below minLevel: compiled away, prints nothing
+	int probes = 0;
+	LOG(Debug, "Probe %d", ++probes); // the argument is not evaluated either: probes stays 0
+	LOG(Info, "Probes run: %d", probes); // [INFO]: Probes run: 0
+	// log<Level::Error>("An error has occured %s times", 3); // does not compile: %s expects a string
+
 
 
 